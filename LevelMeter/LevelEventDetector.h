@@ -0,0 +1,424 @@
+/*
+ ==============================================================================
+ Copyright (c) 2017 - 2020 Foleys Finest Audio Ltd. - Daniel Walz
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+ 1. Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+ 3. Neither the name of the copyright holder nor the names of its contributors
+    may be used to endorse or promote products derived from this software without
+    specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ==============================================================================
+
+    LevelEventDetector.h
+    Author:  Daniel Walz
+
+ ==============================================================================
+ */
+
+#pragma once
+
+namespace foleys
+{
+
+/** @addtogroup ff_meters */
+/*@{*/
+
+/**
+ \class LevelEventDetector
+
+ Watches the levels sample by sample and reports, when a Rule starts or stops to apply,
+ e.g. dead air, overs or an imbalance between two channels. Call process from the audio
+ thread or wherever the samples are analysed. The events carry the sample position, where
+ the condition started or ended, and are collected by popEvent from one other thread. The
+ queue has a single consumer, so if a logger and a UI both need the events, pop them on one
+ thread and forward them from there.
+
+ The rules and the number of channels are set in prepare, which must not be called while
+ process is running.
+ */
+class LevelEventDetector
+{
+public:
+    /** What level a Rule looks at */
+    enum class Measure
+    {
+        SamplePeak = 0,   /**< The magnitude of each sample */
+        TruePeak,         /**< The estimated inter sample peak, \see LevelMeterMetrics::TruePeak */
+        RMS               /**< The RMS with an exponential integration time of rmsSeconds */
+    };
+
+    /** When a Rule applies */
+    enum class Condition
+    {
+        Above = 0,        /**< The level is above the threshold */
+        Below,            /**< The level is below the threshold */
+        Imbalance         /**< The levels of channel and otherChannel differ by more than the threshold */
+    };
+
+    struct Rule
+    {
+        Condition condition          = Condition::Above;
+        Measure   measure            = Measure::SamplePeak;
+        int       channel            = -1;     /**< The channel to watch, -1 watches each channel separately */
+        int       otherChannel       = 1;      /**< The second channel for Condition::Imbalance */
+        float     thresholdDecibels  = 0.0f;
+        float     hysteresisDecibels = 1.0f;   /**< How far the level has to return, before the rule stops to apply */
+        double    minDurationSeconds = 0.0;    /**< How long the condition has to hold, before the rule applies */
+        double    releaseSeconds     = 0.05;   /**< How long the level has to stay back, before the rule stops to apply. The default bridges the zero crossings down to 10 Hz */
+        double    rmsSeconds         = 0.3;    /**< The integration time for Measure::RMS, each rule may use its own */
+
+        /** Signal below the threshold on any channel for longer than the duration */
+        static Rule deadAir (float thresholdDecibels = -60.0f, double seconds = 5.0)
+        {
+            Rule rule;
+            rule.condition          = Condition::Below;
+            rule.measure            = Measure::SamplePeak;
+            rule.thresholdDecibels  = thresholdDecibels;
+            rule.hysteresisDecibels = 3.0f;
+            rule.minDurationSeconds = seconds;
+            return rule;
+        }
+
+        /** True peak above the threshold on any channel */
+        static Rule overs (float thresholdDecibels = -1.0f)
+        {
+            Rule rule;
+            rule.condition          = Condition::Above;
+            rule.measure            = Measure::TruePeak;
+            rule.thresholdDecibels  = thresholdDecibels;
+            rule.releaseSeconds     = 0.1;
+            return rule;
+        }
+
+        /** RMS of the two channels differs more than the threshold */
+        static Rule imbalance (int channel = 0, int otherChannel = 1, float thresholdDecibels = 6.0f, double seconds = 1.0)
+        {
+            Rule rule;
+            rule.condition          = Condition::Imbalance;
+            rule.measure            = Measure::RMS;
+            rule.channel            = channel;
+            rule.otherChannel       = otherChannel;
+            rule.thresholdDecibels  = thresholdDecibels;
+            rule.minDurationSeconds = seconds;
+            return rule;
+        }
+    };
+
+    struct Event
+    {
+        enum Type
+        {
+            Started = 0,
+            Ended
+        };
+
+        Type        type           = Started;
+        int         rule           = 0;        /**< The index of the rule in the order given to prepare */
+        int         channel        = 0;
+        juce::int64 samplePosition = 0;        /**< Where the condition started or ended to hold */
+        float       levelDecibels  = -100.0f;  /**< The level, or the difference for Imbalance, when the event was detected */
+    };
+
+    LevelEventDetector (int eventCapacity = 256)
+      : events (eventCapacity)
+    {
+    }
+
+    /**
+     Sets the rules and allocates the state for each. Call this from prepareToPlay.
+     */
+    void prepare (double sampleRateToUse, int numChannelsToUse, const std::vector<Rule>& rulesToUse)
+    {
+        sampleRate  = sampleRateToUse;
+        numChannels = numChannelsToUse;
+        position    = 0;
+
+        rules.clear();
+        states.clear();
+        rmsCoefficients.clear();
+        usesMeasure = {{ true, false, false }};
+        for (const auto& rule : rulesToUse)
+        {
+            PreparedRule prepared;
+            prepared.rule          = rule;
+            prepared.firstState     = static_cast<int> (states.size());
+            prepared.minSamples     = juce::int64 (rule.minDurationSeconds * sampleRate);
+            prepared.releaseSamples = juce::int64 (rule.releaseSeconds * sampleRate);
+
+            const bool power    = rule.measure == Measure::RMS;
+            const auto exponent = power ? 0.1f : 0.05f;
+            const auto distance = rule.condition == Condition::Below ? rule.hysteresisDecibels : -rule.hysteresisDecibels;
+            prepared.threshold  = std::pow (10.0f, rule.thresholdDecibels * exponent);
+            prepared.release    = std::pow (10.0f, (rule.thresholdDecibels + distance) * exponent);
+            prepared.gate       = std::pow (10.0f, imbalanceGateDecibels * exponent);
+
+            states.resize (states.size() + size_t (prepared.numStates (numChannels)));
+            rules.push_back (prepared);
+
+            usesMeasure [size_t (rule.measure)] = true;
+            if (rule.measure == Measure::RMS)
+            {
+                // rules with the same integration time share the RMS
+                const auto coefficient = float (std::exp (-1.0 / (std::max (rule.rmsSeconds, 0.001) * sampleRate)));
+                const auto window      = std::find (rmsCoefficients.begin(), rmsCoefficients.end(), coefficient);
+                rules.back().rmsWindow = static_cast<int> (window - rmsCoefficients.begin());
+                if (window == rmsCoefficients.end())
+                    rmsCoefficients.push_back (coefficient);
+            }
+        }
+
+        levels.assign (size_t (numChannels), ChannelLevels());
+        meanSquares.assign (size_t (numChannels) * rmsCoefficients.size(), 0.0f);
+    }
+
+    /**
+     Analyses a block. The position is the sample position of the first sample, e.g. from the
+     host's play head. If it is negative, the position continues from the previous block.
+     */
+    template<typename FloatType>
+    void process (const juce::AudioBuffer<FloatType>& buffer, juce::int64 startPosition = -1)
+    {
+        if (startPosition >= 0)
+            position = startPosition;
+
+        const auto numSamples = buffer.getNumSamples();
+        const auto channels   = std::min (numChannels, buffer.getNumChannels());
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            for (int c = 0; c < channels; ++c)
+            {
+                auto& level = levels [size_t (c)];
+                const auto sample = static_cast<float> (buffer.getReadPointer (c) [i]);
+
+                level.values [size_t (Measure::SamplePeak)] = std::abs (sample);
+
+                if (usesMeasure [size_t (Measure::TruePeak)])
+                    level.values [size_t (Measure::TruePeak)] = level.interpolator.processSample (sample);
+
+                const auto power      = sample * sample;
+                auto*      meanSquare = meanSquares.data() + size_t (c) * rmsCoefficients.size();
+                for (size_t w = 0; w < rmsCoefficients.size(); ++w)
+                    meanSquare [w] = power + rmsCoefficients [w] * (meanSquare [w] - power);
+            }
+
+            for (size_t r = 0; r < rules.size(); ++r)
+                evaluate (int (r), rules [r], position + i, channels);
+        }
+
+        position += numSamples;
+    }
+
+    /**
+     Takes the oldest event. Call this always from the same thread, e.g. a timer or a logging
+     thread, the queue has a single consumer.
+     */
+    bool popEvent (Event& event)
+    {
+       #if JUCE_DEBUG
+        // a second consumer would race with the first one, see the class description
+        const auto thread = juce::Thread::getCurrentThreadId();
+        auto consumer = consumerThread.load();
+        if (consumer == nullptr && consumerThread.compare_exchange_strong (consumer, thread))
+            consumer = thread;
+
+        jassert (consumer == thread);
+       #endif
+
+        return events.pop (event);
+    }
+
+    /** Returns the number of events, that were lost, because the queue was full */
+    juce::int64 getNumLostEvents() const
+    {
+        return lostEvents.load();
+    }
+
+    /** Returns true, if the rule currently applies to the channel */
+    bool isActive (int rule, int channel = 0) const
+    {
+        if (! juce::isPositiveAndBelow (rule, static_cast<int> (rules.size())))
+            return false;
+
+        const auto& prepared = rules [size_t (rule)];
+        const auto  index    = prepared.firstState + (prepared.numStates (numChannels) > 1 ? channel : 0);
+        return juce::isPositiveAndBelow (index, static_cast<int> (states.size())) && states [size_t (index)].active;
+    }
+
+    double getSampleRate() const
+    {
+        return sampleRate;
+    }
+
+private:
+    struct PreparedRule
+    {
+        Rule        rule;
+        int         firstState     = 0;
+        juce::int64 minSamples     = 0;
+        juce::int64 releaseSamples = 0;
+        float       threshold      = 1.0f;
+        float       release        = 1.0f;
+        float       gate           = 0.0f;
+        int         rmsWindow      = 0;        /**< The index of the integration time for Measure::RMS */
+
+        int numStates (int channels) const
+        {
+            return (rule.condition == Condition::Imbalance || rule.channel >= 0) ? 1 : channels;
+        }
+    };
+
+    struct RuleState
+    {
+        bool        active = false;
+        juce::int64 onset  = -1;
+        juce::int64 offset = -1;
+    };
+
+    /** Below this level both channels are considered silent and not imbalanced */
+    static constexpr float imbalanceGateDecibels = -70.0f;
+
+    /** SamplePeak and TruePeak, the RMS is in meanSquares for each integration time */
+    struct ChannelLevels
+    {
+        std::array<float, 2>                      values {{ 0.0f, 0.0f }};
+        LevelMeterMetrics::TruePeak::Interpolator interpolator;
+    };
+
+    float getLevel (const PreparedRule& prepared, int channel) const
+    {
+        if (prepared.rule.measure == Measure::RMS)
+            return meanSquares [size_t (channel) * rmsCoefficients.size() + size_t (prepared.rmsWindow)];
+
+        return levels [size_t (channel)].values [size_t (prepared.rule.measure)];
+    }
+
+    void evaluate (int index, const PreparedRule& prepared, juce::int64 now, int channels)
+    {
+        const auto& rule = prepared.rule;
+
+        if (rule.condition == Condition::Imbalance)
+        {
+            if (rule.channel >= channels || rule.otherChannel >= channels || rule.channel < 0 || rule.otherChannel < 0)
+                return;
+
+            // compare the larger with the smaller level, so the direction doesn't matter
+            const auto a = getLevel (prepared, rule.channel);
+            const auto b = getLevel (prepared, rule.otherChannel);
+            const auto ratio = std::max (a, b) < prepared.gate ? 1.0f
+                                                               : std::max (a, b) / std::max (std::min (a, b), 1.0e-10f);
+
+            update (index, prepared, states [size_t (prepared.firstState)], rule.channel, ratio,
+                    ratio > prepared.threshold, ratio < prepared.release, now);
+            return;
+        }
+
+        const int first = rule.channel >= 0 ? rule.channel : 0;
+        const int last  = rule.channel >= 0 ? std::min (rule.channel + 1, channels) : channels;
+        for (int c = first; c < last; ++c)
+        {
+            const auto value = getLevel (prepared, c);
+            const bool above = rule.condition == Condition::Above;
+
+            update (index, prepared, states [size_t (prepared.firstState + c - first)], c, value,
+                    above ? value > prepared.threshold : value < prepared.threshold,
+                    above ? value < prepared.release   : value > prepared.release, now);
+        }
+    }
+
+    void update (int index, const PreparedRule& prepared, RuleState& state, int channel, float value,
+                 bool holds, bool released, juce::int64 now)
+    {
+        if (! state.active)
+        {
+            if (! holds)
+            {
+                state.onset = -1;
+                return;
+            }
+
+            if (state.onset < 0)
+                state.onset = now;
+
+            if (now - state.onset >= prepared.minSamples)
+            {
+                state.active = true;
+                state.offset = -1;
+                push (Event::Started, index, channel, state.onset, value, prepared.rule.measure);
+            }
+        }
+        else
+        {
+            if (! released)
+            {
+                state.offset = -1;
+                return;
+            }
+
+            if (state.offset < 0)
+                state.offset = now;
+
+            if (now - state.offset >= prepared.releaseSamples)
+            {
+                state.active = false;
+                state.onset  = -1;
+                push (Event::Ended, index, channel, state.offset, value, prepared.rule.measure);
+            }
+        }
+    }
+
+    void push (Event::Type type, int rule, int channel, juce::int64 samplePosition, float value, Measure measure)
+    {
+        Event event;
+        event.type           = type;
+        event.rule           = rule;
+        event.channel        = channel;
+        event.samplePosition = samplePosition;
+        event.levelDecibels  = std::max (-100.0f, (measure == Measure::RMS ? 10.0f : 20.0f) * std::log10 (std::max (value, 1.0e-20f)));
+
+        if (! events.push (event))
+            ++lostEvents;
+    }
+
+    double                     sampleRate     = 44100.0;
+    int                        numChannels    = 0;
+    juce::int64                position       = 0;
+    std::array<bool, 3>        usesMeasure    {{ true, false, false }};
+
+    std::vector<PreparedRule>  rules;
+    std::vector<RuleState>     states;
+    std::vector<ChannelLevels> levels;
+    std::vector<float>         rmsCoefficients;  /**< One for each distinct rmsSeconds */
+    std::vector<float>         meanSquares;      /**< numChannels x rmsCoefficients */
+
+    LockFreeFifo<Event>        events;
+    std::atomic<juce::int64>   lostEvents { 0 };
+
+   #if JUCE_DEBUG
+    std::atomic<juce::Thread::ThreadID> consumerThread { nullptr };
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelEventDetector)
+};
+
+/*@}*/
+
+} // end namespace foleys
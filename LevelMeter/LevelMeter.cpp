@@ -67,27 +67,34 @@ LevelMeter::~LevelMeter()
 void LevelMeter::setMeterFlags (MeterFlags type)
 {
     meterType = type;
+    layoutNeedsUpdate = true;
 }
 
 void LevelMeter::setMeterSource (LevelMeterSource* src)
 {
     source = src;
+    cursor.reset();
+    registration.setConsumers (src != nullptr ? &src->getConsumers() : nullptr);
+    registration.setInterested (isShowing());
     repaint();
 }
 
 void LevelMeter::setSelectedChannel (int c)
 {
     selectedChannel = c;
+    layoutNeedsUpdate = true;
 }
 
 void LevelMeter::setFixedNumChannels (int numChannels)
 {
     fixedNumChannels = numChannels;
+    layoutNeedsUpdate = true;
 }
 
 void LevelMeter::setRefreshRateHz (int newRefreshRate)
 {
     refreshRate = newRefreshRate;
+    idleTicks   = 0;
     startTimerHz (refreshRate);
 }
 
@@ -110,18 +117,22 @@ void LevelMeter::paint (juce::Graphics& g)
             backgroundNeedsRepaint = false;
         }
         g.drawImageAt (backgroundImage, 0, 0);
-        lmLookAndFeel->drawMeterBars (g, meterType, bounds, source, fixedNumChannels, selectedChannel);
     }
     else
     {
         lmLookAndFeel->drawBackground (g, meterType, bounds);
         lmLookAndFeel->drawMeterBarsBackground (g, meterType, bounds, numChannels, fixedNumChannels);
-        lmLookAndFeel->drawMeterBars (g, meterType, bounds, source, fixedNumChannels, selectedChannel);
     }
 
-    if (source)
+    if (lmBatchedLookAndFeel != nullptr && source != nullptr)
     {
-        source->decayIfNeeded();
+        updateLayoutIfNeeded (numChannels);
+        readLevels();
+        lmBatchedLookAndFeel->drawMeterBarsBatched (g, meterType, layout, levels);
+    }
+    else
+    {
+        lmLookAndFeel->drawMeterBars (g, meterType, bounds, source, fixedNumChannels, selectedChannel);
     }
 }
 
@@ -129,22 +140,69 @@ void LevelMeter::resized ()
 {
     lmLookAndFeel->updateMeterGradients();
     backgroundNeedsRepaint = true;
+    layoutNeedsUpdate = true;
+}
+
+void LevelMeter::updateLayoutIfNeeded (int numChannels)
+{
+    if (! layoutNeedsUpdate && layout.numChannels == numChannels)
+        return;
+
+    layout.clear();
+    lmBatchedLookAndFeel->computeMeterLayout (layout, meterType, getLocalBounds().toFloat(),
+                                              numChannels, fixedNumChannels, selectedChannel);
+    layout.bounds           = getLocalBounds().toFloat();
+    layout.meterType        = meterType;
+    layout.numChannels      = numChannels;
+    layout.fixedNumChannels = fixedNumChannels;
+    layout.selectedChannel  = selectedChannel;
+
+    levels.resize (layout.size());
+    layoutNeedsUpdate = false;
+}
+
+void LevelMeter::readLevels()
+{
+    const auto* src = source.get();
+    for (int i = 0; i < layout.size(); ++i)
+    {
+        const auto channel = layout.channels [size_t (i)];
+        levels.rms        [size_t (i)] = src->getRMSLevel (channel);
+        levels.peak       [size_t (i)] = src->getMaxLevel (channel);
+        levels.maxOverall [size_t (i)] = src->getMaxOverallLevel (channel);
+        levels.reduction  [size_t (i)] = src->getReductionLevel (channel);
+        levels.clip       [size_t (i)] = src->getClipFlag (channel) ? 1 : 0;
+    }
 }
 
 void LevelMeter::visibilityChanged ()
 {
     backgroundNeedsRepaint = true;
+    registration.setInterested (isShowing());
 }
 
 void LevelMeter::timerCallback ()
 {
-    if ((source && source->checkNewDataFlag()) || backgroundNeedsRepaint)
+    // a parent being hidden doesn't call visibilityChanged, so this is checked here as well
+    registration.setInterested (isShowing());
+
+    if (source)
+        source->decayIfNeeded();
+
+    const bool hasNewData = source && cursor.consumeNewData (*source);
+    if (hasNewData || backgroundNeedsRepaint)
     {
-        if (source)
-            source->resetNewDataFlag();
+        if (idleTicks >= refreshRate)
+            startTimerHz (refreshRate);
 
+        idleTicks = 0;
         repaint();
     }
+    else if (++idleTicks == refreshRate)
+    {
+        // nothing changed for a second, check less often until the source has new data
+        startTimerHz (idleRefreshRate);
+    }
 }
 
 void LevelMeter::clearClipIndicator (int channel)
@@ -214,6 +272,7 @@ void LevelMeter::removeListener (LevelMeter::Listener* listener)
 
 void LevelMeter::parentHierarchyChanged()
 {
+    registration.setInterested (isShowing());
     lookAndFeelChanged();
 }
 
@@ -222,15 +281,19 @@ void LevelMeter::lookAndFeelChanged()
     if (auto* lnf = dynamic_cast<LookAndFeelMethods*> (&getLookAndFeel()))
     {
         lmLookAndFeel = lnf;
+        lmBatchedLookAndFeel = dynamic_cast<BatchedLookAndFeelMethods*> (&getLookAndFeel());
         fallbackLookAndFeel.reset();
     }
     else
     {
         if (fallbackLookAndFeel.get() == nullptr)
-            fallbackLookAndFeel = std::make_unique<LevelMeterLookAndFeel>();
+            fallbackLookAndFeel = std::make_unique<BatchedLevelMeterLookAndFeel>();
 
         lmLookAndFeel = fallbackLookAndFeel.get();
+        lmBatchedLookAndFeel = fallbackLookAndFeel.get();
     }
+
+    layoutNeedsUpdate = true;
 }
 
 } // namespace foleys
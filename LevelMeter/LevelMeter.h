@@ -42,6 +42,7 @@ namespace foleys
 /*@{*/
 
 class LevelMeterLookAndFeel;
+class BatchedLevelMeterLookAndFeel;
 
 //==============================================================================
 /*
@@ -225,6 +226,102 @@ public:
                                       const LevelMeterSource* source) const = 0;
     };
 
+    /**
+     The placement of all drawn channels. It is computed by the LookAndFeel only when the
+     size, the flags or the number of channels change, and then reused for every frame.
+     Each vector has one entry per drawn channel.
+     */
+    struct MeterLayout
+    {
+        std::vector<int>                    channels;           /**< The source channel index for each drawn channel */
+        std::vector<juce::Rectangle<float>> barBounds;          /**< The placement of the actual meter bar */
+        std::vector<juce::Rectangle<float>> reductionBounds;    /**< The placement of the reduction overlay, may be empty */
+        std::vector<juce::Rectangle<float>> clipBounds;         /**< The placement of the clip indicator, may be empty */
+        std::vector<juce::Rectangle<float>> maxNumberBounds;    /**< The placement of the max level number, may be empty */
+
+        juce::Rectangle<float> bounds;
+        MeterFlags             meterType        = Default;
+        int                    numChannels      = -1;
+        int                    fixedNumChannels = -1;
+        int                    selectedChannel  = -1;
+
+        int size() const { return static_cast<int> (channels.size()); }
+
+        void clear()
+        {
+            channels.clear();
+            barBounds.clear();
+            reductionBounds.clear();
+            clipBounds.clear();
+            maxNumberBounds.clear();
+        }
+
+        void add (int channel,
+                  juce::Rectangle<float> bar,
+                  juce::Rectangle<float> reduction,
+                  juce::Rectangle<float> clip,
+                  juce::Rectangle<float> maxNumber)
+        {
+            channels.push_back (channel);
+            barBounds.push_back (bar);
+            reductionBounds.push_back (reduction);
+            clipBounds.push_back (clip);
+            maxNumberBounds.push_back (maxNumber);
+        }
+    };
+
+    /**
+     The readings of all drawn channels as struct-of-arrays, in the order of MeterLayout::channels.
+     The storage is kept by the LevelMeter, so reading a frame doesn't allocate.
+     */
+    struct MeterLevels
+    {
+        std::vector<float>        rms;
+        std::vector<float>        peak;
+        std::vector<float>        maxOverall;
+        std::vector<float>        reduction;
+        std::vector<juce::uint8>  clip;
+
+        int size() const { return static_cast<int> (rms.size()); }
+
+        void resize (int numChannels)
+        {
+            const auto n = size_t (numChannels);
+            rms.resize (n);
+            peak.resize (n);
+            maxOverall.resize (n);
+            reduction.resize (n);
+            clip.resize (n);
+        }
+    };
+
+    /**
+     This optional interface allows a LookAndFeel to draw all channels in one call. If the
+     LookAndFeel of the meter implements it, the LevelMeter computes the MeterLayout once on resize
+     and reads all levels into MeterLevels before calling drawMeterBarsBatched. Otherwise the
+     per channel callbacks of LookAndFeelMethods are used.
+     There is a default implementation to be included in your custom LookAndFeel class,
+     \see LevelMeterBatchedLookAndFeelMethods.h
+     */
+    class BatchedLookAndFeelMethods {
+    public:
+        virtual ~BatchedLookAndFeelMethods() {}
+
+        /** Fill the layout with the placement of all channels to be drawn */
+        virtual void computeMeterLayout (MeterLayout& layout,
+                                         MeterFlags meterType,
+                                         juce::Rectangle<float> bounds,
+                                         int numChannels,
+                                         int fixedNumChannels,
+                                         int selectedChannel) const = 0;
+
+        /** Draw all channels of the layout with their levels on top of the static background */
+        virtual void drawMeterBarsBatched (juce::Graphics&,
+                                           MeterFlags meterType,
+                                           const MeterLayout& layout,
+                                           const MeterLevels& levels) = 0;
+    };
+
     LevelMeter (MeterFlags type = HasBorder);
     ~LevelMeter () override;
 
@@ -258,6 +355,10 @@ public:
      */
     void setFixedNumChannels (int numChannels);
 
+    /**
+     Set the rate to check the source for new data. The meter only repaints, if the readings
+     changed visibly. After a second without changes it checks only a few times per second.
+     */
     void setRefreshRateHz (int newRefreshRate);
 
     /**
@@ -333,19 +434,31 @@ public:
 
 private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelMeter)
-    
+
+    void updateLayoutIfNeeded (int numChannels);
+    void readLevels();
+
     juce::WeakReference<foleys::LevelMeterSource> source;
+    foleys::LevelMeterSource::Cursor              cursor;
+    MeterConsumers::Registration                  registration;
 
     int                                   selectedChannel  = -1;
     int                                   fixedNumChannels = -1;
     MeterFlags                            meterType = HasBorder;
     int                                   refreshRate = 30;
+    int                                   idleTicks   = 0;
+    static constexpr int                  idleRefreshRate = 4;
     bool                                  useBackgroundImage = false;
     juce::Image                           backgroundImage;
     bool                                  backgroundNeedsRepaint = true;
 
-    std::unique_ptr<LevelMeterLookAndFeel> fallbackLookAndFeel;
+    std::unique_ptr<BatchedLevelMeterLookAndFeel> fallbackLookAndFeel;
     LevelMeter::LookAndFeelMethods*        lmLookAndFeel = nullptr;
+    LevelMeter::BatchedLookAndFeelMethods* lmBatchedLookAndFeel = nullptr;
+
+    MeterLayout                            layout;
+    MeterLevels                            levels;
+    bool                                   layoutNeedsUpdate = true;
 
     juce::ListenerList<foleys::LevelMeter::Listener> listeners;
 };
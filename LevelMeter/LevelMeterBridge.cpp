@@ -0,0 +1,322 @@
+/*
+ ==============================================================================
+ Copyright (c) 2017 - 2020 Foleys Finest Audio Ltd. - Daniel Walz
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+ 1. Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+ 3. Neither the name of the copyright holder nor the names of its contributors
+    may be used to endorse or promote products derived from this software without
+    specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ==============================================================================
+
+    LevelMeterBridge.cpp
+    Author:  Daniel Walz
+
+ ==============================================================================
+*/
+
+namespace foleys
+{
+
+LevelMeterBridge::LevelMeterBridge (LevelMeter::MeterFlags type)
+  : meterType (type | LevelMeter::SingleChannel)
+{
+    lookAndFeelChanged();
+
+    onColumnClicked = [](LevelMeterSource& source, int channel, [[maybe_unused]] juce::ModifierKeys mods)
+    {
+        // default clear the clicked channel. Overwrite this lambda to change the behaviour
+        source.clearMaxNum (channel);
+        source.clearClipFlag (channel);
+    };
+
+    startTimerHz (refreshRate);
+}
+
+LevelMeterBridge::~LevelMeterBridge()
+{
+    stopTimer();
+}
+
+void LevelMeterBridge::addSource (LevelMeterSource* source)
+{
+    if (source == nullptr)
+        return;
+
+    for (int channel=0; channel < source->getNumChannels(); ++channel)
+        addColumn (source, channel);
+
+    updateSize();
+}
+
+void LevelMeterBridge::addChannel (LevelMeterSource* source, int channel)
+{
+    if (source == nullptr)
+        return;
+
+    addColumn (source, channel);
+    updateSize();
+}
+
+void LevelMeterBridge::addColumn (LevelMeterSource* source, int channel)
+{
+    Column column;
+    column.source  = source;
+    column.channel = channel;
+    column.registration.setConsumers (&source->getConsumers());
+    columns.push_back (std::move (column));
+    visibleColumns = {};
+}
+
+void LevelMeterBridge::clearColumns ()
+{
+    columns.clear();
+    visibleStates.clear();
+    visibleColumns = {};
+    updateSize();
+}
+
+int LevelMeterBridge::getNumColumns () const
+{
+    return static_cast<int> (columns.size());
+}
+
+void LevelMeterBridge::setColumnSize (int newColumnSize)
+{
+    columnSize = std::max (1, newColumnSize);
+    updateSize();
+}
+
+void LevelMeterBridge::setMeterFlags (LevelMeter::MeterFlags type)
+{
+    meterType = type | LevelMeter::SingleChannel;
+    updateSize();
+}
+
+void LevelMeterBridge::setRefreshRateHz (int newRefreshRate)
+{
+    refreshRate = newRefreshRate;
+    startTimerHz (refreshRate);
+}
+
+void LevelMeterBridge::updateSize ()
+{
+    const auto total = getNumColumns() * columnSize;
+    if (meterType & LevelMeter::Horizontal)
+        setSize (getWidth(), total);
+    else
+        setSize (total, getHeight());
+
+    repaint();
+}
+
+juce::Rectangle<int> LevelMeterBridge::getColumnBounds (int column) const
+{
+    if (meterType & LevelMeter::Horizontal)
+        return { 0, column * columnSize, getWidth(), columnSize };
+
+    return { column * columnSize, 0, columnSize, getHeight() };
+}
+
+juce::Range<int> LevelMeterBridge::getColumnsInside (juce::Rectangle<int> area) const
+{
+    const bool horizontal = meterType & LevelMeter::Horizontal;
+    const auto start = horizontal ? area.getY()      : area.getX();
+    const auto end   = horizontal ? area.getBottom() : area.getRight();
+
+    const auto first = juce::jlimit (0, getNumColumns(), start / columnSize);
+    const auto last  = juce::jlimit (first, getNumColumns(), (end + columnSize - 1) / columnSize);
+    return { first, last };
+}
+
+juce::Rectangle<int> LevelMeterBridge::getVisibleArea () const
+{
+    auto area = getLocalBounds();
+    for (auto* parent = getParentComponent(); parent != nullptr; parent = parent->getParentComponent())
+        area = area.getIntersection (getLocalArea (parent, parent->getLocalBounds()));
+
+    return area;
+}
+
+juce::Range<int> LevelMeterBridge::getVisibleColumns () const
+{
+    return getColumnsInside (getVisibleArea());
+}
+
+int LevelMeterBridge::getColumnAt (juce::Point<int> position) const
+{
+    const auto offset = (meterType & LevelMeter::Horizontal) ? position.getY() : position.getX();
+    const auto column = offset / columnSize;
+    return juce::isPositiveAndBelow (column, getNumColumns()) ? column : -1;
+}
+
+void LevelMeterBridge::paint (juce::Graphics& g)
+{
+    juce::Graphics::ScopedSaveState saved (g);
+
+    // the background of the whole component, the graphics only fill the dirty part of it
+    const auto clip = g.getClipBounds();
+    lmLookAndFeel->drawBackground (g, meterType, getLocalBounds().toFloat());
+
+    const auto range = getColumnsInside (clip);
+    for (int c = range.getStart(); c < range.getEnd(); ++c)
+    {
+        const auto& column = columns [size_t (c)];
+        const auto  bounds = getColumnBounds (c).toFloat();
+        lmLookAndFeel->drawMeterChannelBackground (g, meterType, bounds);
+
+        auto* source = column.source.get();
+        if (source != nullptr && juce::isPositiveAndBelow (column.channel, source->getNumChannels()))
+            lmLookAndFeel->drawMeterChannel (g, meterType, bounds, source, column.channel);
+    }
+}
+
+void LevelMeterBridge::resized ()
+{
+    lmLookAndFeel->updateMeterGradients();
+    visibleColumns = {};
+}
+
+void LevelMeterBridge::visibilityChanged ()
+{
+    visibleColumns = {};
+    updateRegistrations();
+}
+
+void LevelMeterBridge::updateRegistrations ()
+{
+    // only the sources of visible columns need to be measured
+    const auto visible = isShowing() ? visibleColumns : juce::Range<int>();
+    for (int c = 0; c < getNumColumns(); ++c)
+        columns [size_t (c)].registration.setInterested (visible.contains (c));
+}
+
+void LevelMeterBridge::timerCallback ()
+{
+    if (! isShowing())
+    {
+        if (! visibleColumns.isEmpty())
+        {
+            visibleColumns = {};
+            updateRegistrations();
+        }
+        return;
+    }
+
+    const auto visible = getVisibleColumns();
+    if (visible != visibleColumns)
+    {
+        // only the visible window is kept, the columns scrolled in are painted by the scrolling anyway
+        visibleColumns = visible;
+        visibleStates.assign (size_t (visible.getLength()), ColumnState());
+        updateRegistrations();
+    }
+
+    LevelMeterSource* lastSource = nullptr;
+    for (int c = visible.getStart(); c < visible.getEnd(); ++c)
+    {
+        const auto& column = columns [size_t (c)];
+        auto* source = column.source.get();
+        if (source == nullptr)
+            continue;
+
+        if (source != lastSource)
+        {
+            source->decayIfNeeded();
+            lastSource = source;
+        }
+
+        if (! juce::isPositiveAndBelow (column.channel, source->getNumChannels()))
+            continue;
+
+        auto& state = visibleStates [size_t (c - visible.getStart())];
+
+        // silent channels, that were already painted at the bottom, only compare the held values, but
+        // not the RMS: a transient between two ticks or a clear from code changes them without the
+        // channel being active in the last block
+        if (state.settled && ! source->isChannelActive (column.channel)
+            && source->getMaxLevel (column.channel) == state.peak
+            && source->getMaxOverallLevel (column.channel) == state.maxOverall
+            && source->getClipFlag (column.channel) == state.clip)
+            continue;
+
+        const ColumnState current { source->getRMSLevel (column.channel),
+                                    source->getMaxLevel (column.channel),
+                                    source->getMaxOverallLevel (column.channel),
+                                    source->getReductionLevel (column.channel),
+                                    source->getClipFlag (column.channel) };
+
+        if (current.rms != state.rms || current.peak != state.peak || current.maxOverall != state.maxOverall
+            || current.reduction != state.reduction || current.clip != state.clip)
+        {
+            state = current;
+            repaint (getColumnBounds (c));
+        }
+
+        state.settled = current.rms < 1.0e-5f && current.peak < 1.0e-5f;
+    }
+}
+
+void LevelMeterBridge::mouseDown (const juce::MouseEvent& event)
+{
+    const auto c = getColumnAt (event.getPosition());
+    if (c < 0 || ! event.mods.isLeftButtonDown())
+        return;
+
+    const auto& column = columns [size_t (c)];
+    auto* source = column.source.get();
+    if (source == nullptr || ! juce::isPositiveAndBelow (column.channel, source->getNumChannels()))
+        return;
+
+    const auto bounds   = getColumnBounds (c).toFloat();
+    const auto position = event.getPosition().toFloat();
+    if (lmLookAndFeel->getMeterClipIndicatorBounds (bounds, meterType).contains (position)
+        || lmLookAndFeel->getMeterMaxNumberBounds (bounds, meterType).contains (position))
+    {
+        if (onColumnClicked)
+            onColumnClicked (*source, column.channel, event.mods);
+
+        repaint (getColumnBounds (c));
+    }
+}
+
+void LevelMeterBridge::parentHierarchyChanged()
+{
+    lookAndFeelChanged();
+}
+
+void LevelMeterBridge::lookAndFeelChanged()
+{
+    if (auto* lnf = dynamic_cast<LevelMeter::LookAndFeelMethods*> (&getLookAndFeel()))
+    {
+        lmLookAndFeel = lnf;
+        fallbackLookAndFeel.reset();
+    }
+    else
+    {
+        if (fallbackLookAndFeel.get() == nullptr)
+            fallbackLookAndFeel = std::make_unique<LevelMeterLookAndFeel>();
+
+        lmLookAndFeel = fallbackLookAndFeel.get();
+    }
+}
+
+} // namespace foleys
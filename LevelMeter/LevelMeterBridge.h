@@ -0,0 +1,160 @@
+/*
+ ==============================================================================
+ Copyright (c) 2017 - 2020 Foleys Finest Audio Ltd. - Daniel Walz
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+ 1. Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+ 3. Neither the name of the copyright holder nor the names of its contributors
+    may be used to endorse or promote products derived from this software without
+    specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ OF THE POSSIBILITY OF SUCH DAMAGE.
+ ==============================================================================
+
+
+    LevelMeterBridge.h
+    Author:  Daniel Walz
+
+ ==============================================================================
+*/
+
+#pragma once
+
+namespace foleys
+{
+
+/** @addtogroup ff_meters */
+/*@{*/
+
+//==============================================================================
+/*
+ \class LevelMeterBridge
+ \brief A component to display many channels of one or more LevelMeterSources
+
+ Instead of one LevelMeter per source this draws all channels as columns inside a
+ single component with one timer. Put it into a juce::Viewport to scroll: only the
+ columns inside the visible area are read and painted, and only their last readings
+ are kept, so the cost scales with the visible columns and not with the number of
+ channels in the session.
+ The drawing uses the LevelMeter::LookAndFeelMethods of the LookAndFeel.
+*/
+class LevelMeterBridge : public juce::Component, private juce::Timer
+{
+public:
+    LevelMeterBridge (LevelMeter::MeterFlags type = LevelMeter::Default);
+    ~LevelMeterBridge () override;
+
+    /**
+     Adds a column for each channel of the source. If the source changes the number of
+     channels later, the columns are not updated.
+     */
+    void addSource (LevelMeterSource* source);
+
+    /**
+     Adds a single column to display one channel of the source.
+     */
+    void addChannel (LevelMeterSource* source, int channel);
+
+    /**
+     Removes all columns.
+     */
+    void clearColumns ();
+
+    int getNumColumns () const;
+
+    /**
+     Set the size of each column. This is the width for vertical meters or the height
+     for horizontal meters. The component is resized along that axis to fit all columns.
+     */
+    void setColumnSize (int newColumnSize);
+
+    /**
+     Allows to change the meter's configuration by setting a combination of MeterFlags.
+     SingleChannel is always added, since each column shows one channel.
+     */
+    void setMeterFlags (LevelMeter::MeterFlags type);
+
+    void setRefreshRateHz (int newRefreshRate);
+
+    /**
+     Returns the bounds of a column. They are computed on demand from the index.
+     */
+    juce::Rectangle<int> getColumnBounds (int column) const;
+
+    /**
+     Returns the range of columns, that are currently not scrolled or clipped away.
+     */
+    juce::Range<int> getVisibleColumns () const;
+
+    /**
+     This lambda is called when the user clicks on a clip light or the max number of a column.
+     It is initially set to clear the clip light and max level of the clicked channel.
+     */
+    std::function<void(LevelMeterSource& source, int channel, juce::ModifierKeys mods)> onColumnClicked;
+
+    void paint (juce::Graphics&) override;
+    void resized () override;
+    void visibilityChanged () override;
+    void mouseDown (const juce::MouseEvent& event) override;
+    void parentHierarchyChanged () override;
+    void lookAndFeelChanged () override;
+
+private:
+    struct Column
+    {
+        juce::WeakReference<LevelMeterSource> source;
+        int                                   channel = 0;
+        MeterConsumers::Registration          registration;
+    };
+
+    /** The last readings of a visible column, to repaint only the columns that changed */
+    struct ColumnState
+    {
+        float rms        = -1.0f;
+        float peak       = -1.0f;
+        float maxOverall = -1.0f;
+        float reduction  = -1.0f;
+        bool  clip       = false;
+        bool  settled    = false;    /**< silent and already painted at the bottom */
+    };
+
+    void timerCallback () override;
+    void addColumn (LevelMeterSource* source, int channel);
+    void updateSize ();
+    void updateRegistrations ();
+    int  getColumnAt (juce::Point<int> position) const;
+    juce::Rectangle<int> getVisibleArea () const;
+    juce::Range<int> getColumnsInside (juce::Rectangle<int> area) const;
+
+    std::vector<Column>      columns;
+    std::vector<ColumnState> visibleStates;
+    juce::Range<int>         visibleColumns;
+
+    LevelMeter::MeterFlags   meterType  = LevelMeter::SingleChannel;
+    int                      columnSize = 30;
+    int                      refreshRate = 30;
+
+    std::unique_ptr<LevelMeterLookAndFeel> fallbackLookAndFeel;
+    LevelMeter::LookAndFeelMethods*        lmLookAndFeel = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelMeterBridge)
+};
+
+/*@}*/
+
+} // end namespace foleys
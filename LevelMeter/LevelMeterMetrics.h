@@ -0,0 +1,508 @@
+/*
+ ==============================================================================
+ Copyright (c) 2017 - 2020 Foleys Finest Audio Ltd. - Daniel Walz
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+ 1. Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+ 3. Neither the name of the copyright holder nor the names of its contributors
+    may be used to endorse or promote products derived from this software without
+    specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ==============================================================================
+
+    LevelMeterMetrics.h
+    Author:  Daniel Walz
+
+ ==============================================================================
+ */
+
+#pragma once
+
+namespace foleys
+{
+
+/** @addtogroup ff_meters */
+/*@{*/
+
+/**
+ The metrics a BasicLevelMeterSource can measure. Each metric carries the State it needs
+ per channel. Metrics, that are not selected, add no members to the channel data and no
+ code to measureBlock.
+ */
+namespace LevelMeterMetrics
+{
+
+/**
+ The peak of the last block and the maximum since the last clearMaxNum, which is displayed
+ as number under the bar.
+ */
+struct Peak
+{
+    struct State
+    {
+        State() = default;
+        State (const State& other) :
+        max        (other.max.load()),
+        maxOverall (other.maxOverall.load())
+        {}
+
+        State& operator= (const State& other)
+        {
+            max.store        (other.max.load());
+            maxOverall.store (other.maxOverall.load());
+            publishedMax        = -1.0f;
+            publishedMaxOverall = -1.0f;
+            return *this;
+        }
+
+        std::atomic<float> max        { 0.0f };
+        std::atomic<float> maxOverall { 0.0f };
+        float              publishedMax        = -1.0f;
+        float              publishedMaxOverall = -1.0f;
+    };
+};
+
+/**
+ Keeps the peak for the hold time before it follows the signal down. Requires Peak.
+ */
+struct Hold
+{
+    struct State
+    {
+        State() = default;
+        State (const State& other) : hold (other.hold.load()) {}
+
+        State& operator= (const State& other)
+        {
+            hold.store (other.hold.load());
+            return *this;
+        }
+
+        std::atomic<juce::int64> hold { 0 };
+    };
+};
+
+/**
+ The RMS averaged over the rmsWindow number of blocks. The histories of all channels live in
+ one Arena, that is allocated in a single piece when the source is resized.
+ */
+struct RMS
+{
+    /** Each channel's history starts on a 64 byte boundary */
+    static constexpr size_t alignment = 64 / sizeof (float);
+
+    static size_t getStride (const size_t numBlocks)
+    {
+        return (numBlocks + alignment - 1) / alignment * alignment;
+    }
+
+    /**
+     Holds the RMS histories of all channels in one heap block.
+     */
+    class Arena
+    {
+    public:
+        /** Allocates and clears the histories. Returns the number of blocks each channel gets */
+        size_t allocate (const size_t numChannels, const size_t numBlocks)
+        {
+            stride = getStride (numBlocks);
+            memory.assign (numChannels * stride + alignment, 0.0f);
+
+            const auto misalignment = reinterpret_cast<std::uintptr_t> (memory.data()) % (alignment * sizeof (float));
+            offset = misalignment > 0 ? alignment - misalignment / sizeof (float) : 0;
+            return numBlocks;
+        }
+
+        float* getHistory (const size_t channel)
+        {
+            return stride > 0 ? memory.data() + offset + channel * stride : nullptr;
+        }
+
+    private:
+        std::vector<float> memory;
+        size_t             offset = 0;
+        size_t             stride = 0;
+    };
+
+    struct State
+    {
+        State() = default;
+
+        /** The history is not copied, it belongs to the Arena of the channel */
+        State (const State&) {}
+
+        State& operator= (const State&)
+        {
+            clearHistory();
+            publishedRms = -1.0f;
+            return *this;
+        }
+
+        float getAvgRMS () const
+        {
+            if (rmsSize > 0)
+                return std::sqrt (std::accumulate (rmsHistory, rmsHistory + rmsSize, 0.0f) / static_cast<float> (rmsSize));
+
+            return std::sqrt (rmsSum.load());
+        }
+
+        void pushNextRMS (const float newRMS)
+        {
+            const float squaredRMS = std::min (newRMS * newRMS, 1.0f);
+            if (rmsSize > 0)
+            {
+                rmsHistory [rmsPtr] = squaredRMS;
+                rmsPtr = (rmsPtr + 1) % rmsSize;
+            }
+            else
+            {
+                rmsSum = squaredRMS;
+            }
+        }
+
+        /** Points the history into the memory of an Arena */
+        void setHistory (float* memory, const size_t numBlocks)
+        {
+            rmsHistory = memory;
+            rmsSize    = memory != nullptr ? numBlocks : 0;
+            clearHistory();
+        }
+
+        void clearHistory()
+        {
+            std::fill (rmsHistory, rmsHistory + rmsSize, 0.0f);
+            rmsSum = 0.0f;
+            rmsPtr = 0;
+        }
+
+        float*             rmsHistory = nullptr;
+        size_t             rmsSize    = 0;
+        size_t             rmsPtr     = 0;
+        std::atomic<float> rmsSum     { 0.0f };
+        float              publishedRms = -1.0f;
+    };
+};
+
+/**
+ The RMS with the histories of all channels stored inline in the source, without a separate
+ heap allocation. The Capacity is the number of floats for all channels together, each
+ channel's history is rounded up to a multiple of 16 values. If the requested window doesn't
+ fit, it is shortened.
+ */
+template<size_t Capacity>
+struct InlineRMS : RMS
+{
+    class Arena
+    {
+    public:
+        size_t allocate (const size_t numChannels, size_t numBlocks)
+        {
+            stride = getStride (numBlocks);
+            if (numChannels * stride > Capacity)
+            {
+                // The Capacity is too small for this many channels and this rmsWindow
+                jassertfalse;
+                stride    = numChannels > 0 ? Capacity / numChannels / alignment * alignment : 0;
+                numBlocks = stride;
+            }
+
+            std::fill (memory.begin(), memory.end(), 0.0f);
+            return numBlocks;
+        }
+
+        float* getHistory (const size_t channel)
+        {
+            return stride > 0 ? memory.data() + channel * stride : nullptr;
+        }
+
+    private:
+        alignas (64) std::array<float, Capacity> memory {};
+        size_t stride = 0;
+    };
+};
+
+/**
+ An estimate of the inter sample peaks. The signal is upsampled four times using a cubic
+ interpolation. This is cheaper than the polyphase filter of ITU-R BS.1770, but catches the
+ overs, that the sample peak misses.
+ */
+struct TruePeak
+{
+    /**
+     Interpolates one channel sample by sample. It returns the highest magnitude between the
+     previous sample and the new one, delayed by one sample.
+     */
+    struct Interpolator
+    {
+        float processSample (const float y3)
+        {
+            const float y0 = history [0];
+            const float y1 = history [1];
+            const float y2 = history [2];
+
+            // Catmull-Rom between y1 and y2
+            const float c1 = 0.5f * (y2 - y0);
+            const float c2 = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
+            const float c3 = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
+
+            float peak = std::abs (y3);
+            for (const float t : { 0.25f, 0.5f, 0.75f })
+                peak = std::max (peak, std::abs (((c3 * t + c2) * t + c1) * t + y1));
+
+            history = {{ y1, y2, y3 }};
+            return peak;
+        }
+
+        void reset()
+        {
+            history = {{ 0.0f, 0.0f, 0.0f }};
+        }
+
+        std::array<float, 3> history {{ 0.0f, 0.0f, 0.0f }};
+    };
+
+    struct State
+    {
+        State() = default;
+        State (const State& other) :
+        truePeak    (other.truePeak.load()),
+        maxTruePeak (other.maxTruePeak.load())
+        {}
+
+        State& operator= (const State& other)
+        {
+            truePeak.store    (other.truePeak.load());
+            maxTruePeak.store (other.maxTruePeak.load());
+            interpolator.reset();
+            publishedTruePeak    = -1.0f;
+            publishedMaxTruePeak = -1.0f;
+            return *this;
+        }
+
+        template<typename FloatType>
+        float measure (const FloatType* samples, const int numSamples)
+        {
+            float peak = 0.0f;
+            for (int i = 0; i < numSamples; ++i)
+                peak = std::max (peak, interpolator.processSample (static_cast<float> (samples [i])));
+
+            truePeak = peak;
+            maxTruePeak = std::max (maxTruePeak.load(), peak);
+            return peak;
+        }
+
+        std::atomic<float>   truePeak    { 0.0f };
+        std::atomic<float>   maxTruePeak { 0.0f };
+        Interpolator         interpolator;
+        float                publishedTruePeak    = -1.0f;
+        float                publishedMaxTruePeak = -1.0f;
+    };
+};
+
+/**
+ The clip flag and the number of blocks, that clipped since the clip flag was cleared.
+ */
+struct Clip
+{
+    struct State
+    {
+        State() = default;
+        State (const State& other) :
+        clip     (other.clip.load()),
+        numClips (other.numClips.load())
+        {}
+
+        State& operator= (const State& other)
+        {
+            clip.store     (other.clip.load());
+            numClips.store (other.numClips.load());
+            publishedClip = false;
+            return *this;
+        }
+
+        std::atomic<bool>         clip     { false };
+        std::atomic<juce::uint32> numClips { 0 };
+        bool                      publishedClip = false;
+    };
+};
+
+/**
+ The gain reduction, that is not measured but set by a compressor or limiter.
+ */
+struct Reduction
+{
+    struct State
+    {
+        State() = default;
+        State (const State& other) : reduction (other.reduction.load()) {}
+
+        State& operator= (const State& other)
+        {
+            reduction.store (other.reduction.load());
+            publishedReduction = -1.0f;
+            return *this;
+        }
+
+        std::atomic<float> reduction { 1.0f };
+        float              publishedReduction = -1.0f;
+    };
+};
+
+/**
+ The gain reduction of a processor, computed from its input and output, \see
+ BasicLevelMeterSource::measureBlock. The RMS of the output is compared with the RMS of the
+ input, delayed by the latency of the processor. Both are smoothed with the same time
+ constant, so the two envelopes match.
+ */
+struct GainReduction : Reduction
+{
+    struct State : Reduction::State
+    {
+        State() = default;
+
+        /** The delay line is not copied, it belongs to the channel storage */
+        State (const State& other) : Reduction::State (other) {}
+
+        State& operator= (const State& other)
+        {
+            Reduction::State::operator= (other);
+            inputEnvelope  = 0.0f;
+            outputEnvelope = 0.0f;
+            delayPos       = 0;
+            return *this;
+        }
+
+        /** Points the delay line into memory owned by the channel storage */
+        void setDelay (float* memory, const size_t numSamples)
+        {
+            delay     = memory;
+            delaySize = memory != nullptr ? numSamples : 0;
+            delayPos  = 0;
+        }
+
+        template<typename FloatType>
+        void measureReduction (const FloatType* input, const int numSamples, const float outputRMS, const float smoothing)
+        {
+            if (numSamples <= 0)
+                return;
+
+            const auto n         = size_t (numSamples);
+            const auto fromDelay = std::min (n, delaySize);
+            const auto first     = std::min (fromDelay, delaySize - delayPos);
+
+            // the oldest samples come from the delay line, the rest from the start of this block
+            const auto energy = (sumOfSquares (delay + delayPos, first)
+                                 + sumOfSquares (delay, fromDelay - first)
+                                 + sumOfSquares (input, n - fromDelay)) / float (n);
+
+            std::copy (input + n - fromDelay, input + n - fromDelay + first, delay + delayPos);
+            std::copy (input + n - fromDelay + first, input + n, delay);
+            if (delaySize > 0)
+                delayPos = (delayPos + fromDelay) % delaySize;
+
+            inputEnvelope  += (1.0f - smoothing) * (energy - inputEnvelope);
+            outputEnvelope += (1.0f - smoothing) * (outputRMS * outputRMS - outputEnvelope);
+
+            reduction = inputEnvelope > 1.0e-10f ? std::min (1.0f, std::sqrt (outputEnvelope / inputEnvelope)) : 1.0f;
+        }
+
+        /**
+         While input and output are silent, the ratio of the envelopes stays where it was, so the
+         reduction recovers towards unity with the same time constant instead.
+         */
+        void releaseReduction (const float smoothing)
+        {
+            const auto current = reduction.load();
+            reduction = current < releasedReduction ? current + (1.0f - smoothing) * (1.0f - current) : 1.0f;
+        }
+
+        /** Returns true, once the reduction is back at unity */
+        bool isReleased() const
+        {
+            return reduction.load() >= 1.0f;
+        }
+
+        float* delay          = nullptr;
+        size_t delaySize      = 0;
+        size_t delayPos       = 0;
+        float  inputEnvelope  = 0.0f;
+        float  outputEnvelope = 0.0f;
+
+    private:
+        // less than 0.001 dB is shown as no reduction
+        static constexpr float releasedReduction = 0.9999f;
+
+        template<typename FloatType>
+        static float sumOfSquares (const FloatType* samples, const size_t numSamples)
+        {
+            // independent partial sums, so the compiler can vectorise the loop
+            float sums[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            size_t i = 0;
+            for (; i + 4 <= numSamples; i += 4)
+                for (size_t j = 0; j < 4; ++j)
+                    sums [j] += float (samples [i + j]) * float (samples [i + j]);
+
+            for (; i < numSamples; ++i)
+                sums [0] += float (samples [i]) * float (samples [i]);
+
+            return (sums [0] + sums [1]) + (sums [2] + sums [3]);
+        }
+    };
+};
+
+/** Stands in for the State of a metric, that was not selected. It is empty, so it costs no bytes. */
+template<typename Metric>
+struct Disabled {};
+
+template<typename Metric, typename... Metrics>
+constexpr bool contains = (std::is_base_of<Metric, Metrics>::value || ...);
+
+/** Finds the first of the Metrics, that is or derives from Metric. The type is void, if there is none. */
+template<typename Metric, typename... Metrics>
+struct Find { using type = void; };
+
+template<typename Metric, typename First, typename... Metrics>
+struct Find<Metric, First, Metrics...>
+{
+    using type = std::conditional_t<std::is_base_of<Metric, First>::value, First, typename Find<Metric, Metrics...>::type>;
+};
+
+/** The State of the selected Metric, or Disabled, if it wasn't selected */
+template<typename SelectedMetric, typename Metric>
+struct StateOfSelected { using type = typename SelectedMetric::State; };
+
+template<typename Metric>
+struct StateOfSelected<void, Metric> { using type = Disabled<Metric>; };
+
+template<typename Metric, typename... Metrics>
+using StateOf = typename StateOfSelected<typename Find<Metric, Metrics...>::type, Metric>::type;
+
+/** The Arena of the selected RMS metric */
+template<typename RMSMetric>
+struct ArenaOf { using type = typename RMSMetric::Arena; };
+
+template<>
+struct ArenaOf<void> { using type = Disabled<RMS>; };
+
+} // namespace LevelMeterMetrics
+
+/*@}*/
+
+} // namespace foleys
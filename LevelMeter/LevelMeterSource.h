@@ -43,198 +43,495 @@ namespace foleys
 /*@{*/
 
 /**
- \class LevelMeterSource
+ \class BasicLevelMeterSource
 
  To get a meter GUI create a LevelMeterSource in your AudioProcessor
  or whatever instance processes an AudioBuffer.
  Then call LevelMeterSource::measureBlock (AudioBuffer<float>& buf) to
  create the readings.
+
+ The Metrics select at compile time, what is measured, see LevelMeterMetrics. E.g. an activity
+ LED only needs `BasicLevelMeterSource<LevelMeterMetrics::Peak>`, which neither computes the RMS
+ nor stores any hold, clip or reduction state. The getters of a metric, that is not selected,
+ don't compile.
  */
-class LevelMeterSource
+template<typename... Metrics>
+class BasicLevelMeterSource
 {
+public:
+    static constexpr bool hasPeak      = LevelMeterMetrics::contains<LevelMeterMetrics::Peak,      Metrics...>;
+    static constexpr bool hasHold      = LevelMeterMetrics::contains<LevelMeterMetrics::Hold,      Metrics...>;
+    static constexpr bool hasRMS       = LevelMeterMetrics::contains<LevelMeterMetrics::RMS,       Metrics...>;
+    static constexpr bool hasTruePeak  = LevelMeterMetrics::contains<LevelMeterMetrics::TruePeak,  Metrics...>;
+    static constexpr bool hasClip      = LevelMeterMetrics::contains<LevelMeterMetrics::Clip,      Metrics...>;
+    static constexpr bool hasReduction = LevelMeterMetrics::contains<LevelMeterMetrics::Reduction, Metrics...>;
+    static constexpr bool hasGainReduction = LevelMeterMetrics::contains<LevelMeterMetrics::GainReduction, Metrics...>;
+
+    static_assert (! hasHold || hasPeak, "The Hold metric holds the Peak, please add LevelMeterMetrics::Peak");
+
 private:
-    class ChannelData
+    class ChannelData : public LevelMeterMetrics::StateOf<LevelMeterMetrics::Peak,      Metrics...>,
+                        public LevelMeterMetrics::StateOf<LevelMeterMetrics::Hold,      Metrics...>,
+                        public LevelMeterMetrics::StateOf<LevelMeterMetrics::RMS,       Metrics...>,
+                        public LevelMeterMetrics::StateOf<LevelMeterMetrics::TruePeak,  Metrics...>,
+                        public LevelMeterMetrics::StateOf<LevelMeterMetrics::Clip,      Metrics...>,
+                        public LevelMeterMetrics::StateOf<LevelMeterMetrics::Reduction, Metrics...>
     {
     public:
-        ChannelData (const size_t rmsWindow = 8) :
-        max (),
-        maxOverall (),
-        clip (false),
-        reduction (1.0f),
-        hold (0),
-        rmsHistory ((size_t) rmsWindow, 0.0),
-        rmsSum (0.0),
-        rmsPtr (0)
-        {}
-
-        ChannelData (const ChannelData& other) :
-        max       (other.max.load() ),
-        maxOverall(other.maxOverall.load() ),
-        clip      (other.clip.load() ),
-        reduction (other.reduction.load()),
-        hold      (other.hold.load()),
-        rmsHistory (8, 0.0),
-        rmsSum    (0.0),
-        rmsPtr    (0)
-        {}
-
-        ChannelData& operator=(const ChannelData& other)
+        void setLevels (const juce::int64 time, const float newMax, const float newRms, const juce::int64 newHoldMSecs)
         {
-            max.store         (other.max.load());
-            maxOverall.store  (other.maxOverall.load());
-            clip.store        (other.clip.load());
-            reduction.store   (other.reduction.load());
-            hold.store        (other.hold.load());
-            rmsHistory.resize (other.rmsHistory.size(), 0.0);
-            rmsSum = 0.0;
-            rmsPtr = 0;
-            return (*this);
-        }
+            juce::ignoreUnused (time, newHoldMSecs);
 
-        std::atomic<float>       max;
-        std::atomic<float>       maxOverall;
-        std::atomic<bool>        clip;
-        std::atomic<float>       reduction;
+            if constexpr (hasClip)
+            {
+                if (newMax > 1.0 || newRms > 1.0)
+                {
+                    this->clip = true;
+                    ++this->numClips;
+                }
+            }
 
-        float getAvgRMS () const
-        {
-            if (rmsHistory.size() > 0)
-                return std::sqrt(std::accumulate (rmsHistory.begin(), rmsHistory.end(), 0.0f) / static_cast<float>(rmsHistory.size()));
-                
-            return float (std::sqrt (rmsSum));
+            if constexpr (hasPeak)
+            {
+                this->maxOverall = fmaxf (this->maxOverall, newMax);
+
+                if constexpr (hasHold)
+                {
+                    if (newMax >= this->max)
+                    {
+                        this->max = std::min (1.0f, newMax);
+                        this->hold = time + newHoldMSecs;
+                    }
+                    else if (time > this->hold)
+                    {
+                        this->max = std::min (1.0f, newMax);
+                    }
+                }
+                else
+                {
+                    this->max = std::min (1.0f, newMax);
+                }
+            }
+
+            if constexpr (hasRMS)
+                this->pushNextRMS (std::min (1.0f, newRms));
         }
 
-        void setLevels (const juce::int64 time, const float newMax, const float newRms, const juce::int64 newHoldMSecs)
+        /**
+         Forgets the running state, but keeps the max numbers and clip flags, that the
+         user has to clear.
+         */
+        void resetRunningState()
         {
-            if (newMax > 1.0 || newRms > 1.0)
-                clip = true;
+            if constexpr (hasPeak)
+                this->max = 0.0f;
 
-            maxOverall = fmaxf (maxOverall, newMax);
-            if (newMax >= max)
-            {
-                max = std::min (1.0f, newMax);
-                hold = time + newHoldMSecs;
-            }
-            else if (time > hold)
+            if constexpr (hasHold)
+                this->hold = 0;
+
+            if constexpr (hasRMS)
+                this->clearHistory();
+
+            if constexpr (hasTruePeak)
             {
-                max = std::min (1.0f, newMax);
+                this->truePeak = 0.0f;
+                this->interpolator.reset();
             }
-            pushNextRMS (std::min (1.0f, newRms));
+
+            settled = false;
         }
 
-        void setRMSsize (const size_t numBlocks)
+        /**
+         Returns true, if all readings fell below what is visible on the meter.
+         */
+        bool isDecayed() const
         {
-            rmsHistory.assign (numBlocks, 0.0);
-            rmsSum  = 0.0;
-            if (numBlocks > 1)
-                rmsPtr %= rmsHistory.size();
-            else
-                rmsPtr = 0;
+            bool decayed = true;
+
+            if constexpr (hasPeak)
+                decayed = decayed && this->max < visibleFloor;
+
+            if constexpr (hasRMS)
+                decayed = decayed && this->getAvgRMS() < visibleFloor;
+
+            if constexpr (hasTruePeak)
+                decayed = decayed && this->truePeak < visibleFloor;
+
+            if constexpr (hasGainReduction)
+                decayed = decayed && this->isReleased();
+
+            return decayed;
         }
-    private:
-        void pushNextRMS (const float newRMS)
+
+        /** Set while the input is silent, the readings have decayed and the reduction is released, so the channel can be skipped */
+        bool settled = false;
+
+        /**
+         Compares the readings with the ones last published to the GUI. If any of them
+         differs by more than the ratio, they are published and true is returned.
+         */
+        bool publishIfChanged (const float ratio)
         {
-            const double squaredRMS = std::min (newRMS * newRMS, 1.0f);
-            if (rmsHistory.size() > 0)
+            juce::ignoreUnused (ratio);
+            bool changed = false;
+
+            if constexpr (hasPeak)
+                changed = publish (this->max.load(), this->publishedMax, ratio)
+                        | publish (this->maxOverall.load(), this->publishedMaxOverall, ratio);
+
+            if constexpr (hasRMS)
+                changed = publish (this->getAvgRMS(), this->publishedRms, ratio) || changed;
+
+            if constexpr (hasTruePeak)
+                changed = (publish (this->truePeak.load(), this->publishedTruePeak, ratio)
+                         | publish (this->maxTruePeak.load(), this->publishedMaxTruePeak, ratio)) || changed;
+
+            if constexpr (hasClip)
             {
-                rmsHistory [(size_t) rmsPtr] = squaredRMS;
-                rmsPtr = (rmsPtr + 1) % rmsHistory.size();
+                if (this->clip != this->publishedClip)
+                {
+                    this->publishedClip = this->clip;
+                    changed = true;
+                }
             }
-            else
+
+            if constexpr (hasReduction)
             {
-                rmsSum = squaredRMS;
+                if (this->reduction != this->publishedReduction)
+                {
+                    this->publishedReduction = this->reduction;
+                    changed = true;
+                }
             }
+
+            return changed;
+        }
+
+    private:
+        // below -100 dB nothing is visible on the meter
+        static constexpr float visibleFloor = 1.0e-5f;
+
+        static bool publish (const float current, float& published, const float ratio)
+        {
+            if (! differs (current, published, ratio))
+                return false;
+
+            published = current;
+            return true;
         }
 
-        std::atomic<juce::int64> hold;
-        std::vector<double>      rmsHistory;
-        std::atomic<double>      rmsSum;
-        size_t                   rmsPtr;
+        static bool differs (const float a, const float b, const float ratio)
+        {
+            if (a < visibleFloor && b < visibleFloor)
+                return false;
+
+            return a > b * ratio || b > a * ratio;
+        }
     };
 
 public:
-    LevelMeterSource () :
+    /**
+     A Cursor remembers the generation of the source, that one consumer has seen last. Each view,
+     recorder or exporter keeps its own Cursor, so any number of them can follow the same source
+     without taking new data away from each other. The audio thread is not involved at all.
+     */
+    class Cursor
+    {
+    public:
+        /** Returns true, if the source has new data since the last call, and marks it as seen */
+        bool consumeNewData (const BasicLevelMeterSource& source)
+        {
+            const auto current = source.getGeneration();
+            if (current == seenGeneration)
+                return false;
+
+            seenGeneration = current;
+            return true;
+        }
+
+        /** Returns true, if the source has new data since the last consumeNewData, without marking it as seen */
+        bool hasNewData (const BasicLevelMeterSource& source) const
+        {
+            return source.getGeneration() != seenGeneration;
+        }
+
+        /** Forget the seen generation, e.g. when switching to a different source */
+        void reset()
+        {
+            seenGeneration = 0;
+        }
+
+    private:
+        juce::uint32 seenGeneration = 0;
+    };
+
+    /**
+     An Aggregate is an extra channel computed from the input channels, e.g. the loudest
+     channel of a 7.1.4 bus or a stereo downmix. The weights are gains for each input channel.
+     If there are no weights, all channels count with 1.0, otherwise channels without a weight
+     don't count.
+     */
+    struct Aggregate
+    {
+        enum Mode
+        {
+            Maximum = 0,    /**< The highest weighted level of all channels */
+            SumOfPowers,    /**< The sum of the weighted channel powers, the peak is the Maximum */
+            Downmix         /**< The level of the weighted sum of the samples */
+        };
+
+        Mode               mode = Maximum;
+        std::vector<float> weights;
+
+        static Aggregate maximum (std::vector<float> weights = {})       { return { Maximum,     std::move (weights) }; }
+        static Aggregate sumOfPowers (std::vector<float> weights = {})   { return { SumOfPowers, std::move (weights) }; }
+        static Aggregate downmix (std::vector<float> weights)            { return { Downmix,     std::move (weights) }; }
+    };
+
+    BasicLevelMeterSource () :
     holdMSecs       (500),
     lastMeasurement (0),
     suspended       (false)
     {}
 
-    ~LevelMeterSource ()
+    ~BasicLevelMeterSource ()
     {
         masterReference.clear();
+
+        Command command;
+        while (commands.pop (command))
+            delete command.storage;
+
+        ChannelStorage* storage = nullptr;
+        while (retiredStorage.pop (storage))
+            delete storage;
+
+        for (auto* retired : unusedStorage)
+            delete retired;
+
+        delete levels.load();
     }
 
     /**
      Resize the meters data containers. Set the
-     \param numChannels to the number of channels. If you don't do this in prepareToPlay,
-            it will be done when calling measureBlock, but a few bytes will be allocated
-            on the audio thread, so be aware.
+     \param numChannels to the number of channels. The new containers are allocated on the
+            calling thread and swapped in before the next block is measured.
      \param rmsWindow is the number of rms values to gather. Keep that aligned with
             the sampleRate and the blocksize to get reproducable results.
             e.g. `rmsWindow = msecs * 0.001f * sampleRate / blockSize;`
      */
     void resize (const int channels, const int rmsWindow)
     {
-        levels.resize (size_t (channels), ChannelData (size_t (rmsWindow)));
-        for (ChannelData& l : levels)
-            l.setRMSsize (size_t (rmsWindow));
+        requestedChannels  = channels;
+        requestedRMSWindow = rmsWindow;
 
-        newDataFlag = true;
+        auto* storage = new ChannelStorage();
+        storage->channels.resize (size_t (channels) + requestedAggregates.size());
+        storage->setAggregates (channels, requestedAggregates);
+
+        if constexpr (hasRMS)
+        {
+            const auto numBlocks = storage->rmsArena.allocate (storage->channels.size(), size_t (std::max (0, rmsWindow)));
+            for (size_t i=0; i < storage->channels.size(); ++i)
+                storage->channels [i].setHistory (storage->rmsArena.getHistory (i), numBlocks);
+        }
+
+        if constexpr (hasGainReduction)
+        {
+            const auto latency = size_t (reductionLatency);
+            storage->reductionDelays.assign (storage->channels.size() * latency, 0.0f);
+            for (size_t i=0; i < storage->channels.size(); ++i)
+                storage->channels [i].setDelay (storage->reductionDelays.data() + i * latency, latency);
+
+            storage->reductionSmoothing = 1.0f - 1.0f / float (std::max (1, rmsWindow));
+        }
+
+        {
+            ScopedStorage current (*this);
+            for (size_t i=0; i < std::min (current->channels.size(), storage->channels.size()); ++i)
+                storage->channels [i] = current->channels [i];
+        }
+
+        Command command;
+        command.type    = Command::SwapStorage;
+        command.storage = storage;
+        sendCommand (command);
+    }
+
+    /**
+     Adds aggregate channels after the input channels. They are computed in the same pass as the
+     input channels and the LevelMeter shows them as extra bars. Like resize, this allocates on
+     the calling thread, so call it from prepareToPlay.
+     */
+    void setAggregates (const std::vector<Aggregate>& aggregates)
+    {
+        requestedAggregates = aggregates;
+        resize (requestedChannels, requestedRMSWindow);
     }
 
     /**
-     Call this method to measure a block af levels to be displayed in the meters
+     Call this method to measure a block af levels to be displayed in the meters.
+     Pending resets and parameter changes from the GUI are applied before the block is measured.
      */
     template<typename FloatType>
     void measureBlock (const juce::AudioBuffer<FloatType>& buffer)
+    {
+        measure (buffer, static_cast<const juce::AudioBuffer<FloatType>*> (nullptr));
+    }
+
+    /**
+     Measures the output of a processor and computes the gain reduction for each channel from
+     its input. The reduction is displayed with the LevelMeter::Reduction flag.
+     Call this after processing with a copy of the input, e.g. from a compressor. If the processor
+     has a latency, set it with \see setReductionLatency, so input and output are aligned.
+     */
+    template<typename FloatType>
+    void measureBlock (const juce::AudioBuffer<FloatType>& input, const juce::AudioBuffer<FloatType>& output)
+    {
+        static_assert (hasGainReduction, "This source has no LevelMeterMetrics::GainReduction");
+        measure (output, &input);
+    }
+
+    /**
+     Set the latency in samples between the input and output passed to measureBlock. Like
+     resize, this allocates on the calling thread, so call it from prepareToPlay.
+     */
+    void setReductionLatency (const int numSamples)
+    {
+        static_assert (hasGainReduction, "This source has no LevelMeterMetrics::GainReduction");
+        reductionLatency = std::max (0, numSamples);
+        resize (requestedChannels, requestedRMSWindow);
+    }
+
+    /**
+     Splits the channels of wide buffers across the workers of the pool. Blocks below the
+     minimum workload of the pool are still measured serially. Call it from prepareToPlay,
+     the pool must outlive the measuring. Set nullptr to always measure serially.
+     */
+    void setWorkerPool (MeterWorkerPool* pool)
+    {
+        workerPool.store (pool, std::memory_order_release);
+    }
+
+private:
+    template<typename FloatType>
+    void measure (const juce::AudioBuffer<FloatType>& buffer, const juce::AudioBuffer<FloatType>* input)
     {
         lastMeasurement = juce::Time::currentTimeMillis();
-        if (! suspended)
+
+        // the GUI is applying commands right now, drop this block instead of waiting
+        if (! tryToAcquireProcessing())
+            return;
+
+        applyCommands();
+
+        if (! suspended && consumers.shouldProcess (buffer.getNumSamples()))
         {
-            const int         numChannels = buffer.getNumChannels ();
+            auto&             storage     = *levels.load (std::memory_order_relaxed);
+            auto&             levelData   = storage.channels;
+            const int         numChannels = std::min (buffer.getNumChannels (), storage.numInputs);
             const int         numSamples  = buffer.getNumSamples ();
+            const float       ratio       = displayRatio.load (std::memory_order_relaxed);
+            bool              changed     = false;
+
+            if (consumers.checkResumed())
+                for (auto& level : levelData)
+                    level.resetRunningState();
+
+            const float floor = silenceFloor.load (std::memory_order_relaxed);
+            for (auto& word : storage.pendingActivity)
+                word.store (0, std::memory_order_relaxed);
 
-            for (int channel=0; channel < std::min (numChannels, int (levels.size())); ++channel) {
-                levels [size_t (channel)].setLevels (lastMeasurement,
-                                                     buffer.getMagnitude (channel, 0, numSamples),
-                                                     buffer.getRMSLevel  (channel, 0, numSamples),
-                                                     holdMSecs);
+            if (auto* pool = workerPool.load (std::memory_order_acquire))
+            {
+                std::atomic<bool> anyChanged { false };
+                pool->forEachChannelRange (numChannels, numSamples, [&] (const int begin, const int end)
+                {
+                    if (measureChannels (storage, buffer, input, begin, end, ratio, floor))
+                        anyChanged.store (true, std::memory_order_relaxed);
+                });
+                changed = anyChanged.load (std::memory_order_relaxed);
+            }
+            else
+            {
+                changed = measureChannels (storage, buffer, input, 0, numChannels, ratio, floor);
             }
+
+            if (! storage.aggregateModes.empty())
+                changed = measureAggregates (storage, buffer, numChannels, ratio, floor) || changed;
+
+            for (size_t i = 0; i < storage.activity.size(); ++i)
+                storage.activity [i].store (storage.pendingActivity [i].load (std::memory_order_relaxed), std::memory_order_relaxed);
+
+            // silent or unchanged signals don't wake up the GUI
+            if (changed)
+                notifyNewData();
         }
 
-        newDataFlag = true;
+        releaseProcessing();
     }
 
+public:
+
     /**
      This is called from the GUI. If processing was stalled, this will pump zeroes into the buffer,
      until the readings return to zero.
      */
     void decayIfNeeded()
     {
+        {
+            // a resize or command on another thread frees them as well, so don't wait for it
+            const std::unique_lock<std::mutex> lock (senderLock, std::try_to_lock);
+            if (lock.owns_lock())
+                deleteRetiredStorage();
+        }
+
         juce::int64 time = juce::Time::currentTimeMillis();
         if (time - lastMeasurement < 100)
             return;
 
+        if (! tryToAcquireProcessing())
+            return;
+
         lastMeasurement = time;
-        for (size_t channel=0; channel < levels.size(); ++channel)
+        applyCommands();
+
+        auto&       levelData = getChannelData();
+        const float ratio     = displayRatio.load (std::memory_order_relaxed);
+        bool        changed   = false;
+        for (size_t channel=0; channel < levelData.size(); ++channel)
         {
-            levels [channel].setLevels (lastMeasurement, 0.0f, 0.0f, holdMSecs);
-            levels [channel].reduction = 1.0f;
+            levelData [channel].setLevels (lastMeasurement, 0.0f, 0.0f, holdMSecs);
+
+            if constexpr (hasTruePeak)
+                levelData [channel].truePeak = 0.0f;
+
+            if constexpr (hasReduction)
+                levelData [channel].reduction = 1.0f;
+
+            changed = levelData [channel].publishIfChanged (ratio) || changed;
         }
 
-        newDataFlag = true;
+        if (changed)
+            notifyNewData();
+
+        releaseProcessing();
     }
 
     /**
      With the reduction level you can add an extra bar do indicate, by what amount the level was reduced.
      This will be printed on top of the bar with half the width.
+     This is usually called from the audio thread. It only stores the value, so it is safe from any thread.
      @param channel the channel index, that was reduced
      @param reduction the factor for the reduction applied to the channel, 1.0=no reduction, 0.0=block completely
      */
     void setReductionLevel (const int channel, const float reduction)
     {
-        if (juce::isPositiveAndBelow (channel, static_cast<int> (levels.size ())))
-            levels [size_t (channel)].reduction = reduction;
+        static_assert (hasReduction, "This source has no LevelMeterMetrics::Reduction");
+        ScopedStorage storage (*this);
+        auto& levelData = storage->channels;
+        if (juce::isPositiveAndBelow (channel, static_cast<int> (levelData.size ())))
+            levelData [size_t (channel)].reduction = reduction;
     }
 
     /**
@@ -244,7 +541,9 @@ public:
      */
     void setReductionLevel (const float reduction)
     {
-        for (auto& channel : levels)
+        static_assert (hasReduction, "This source has no LevelMeterMetrics::Reduction");
+        ScopedStorage storage (*this);
+        for (auto& channel : storage->channels)
             channel.reduction = reduction;
     }
 
@@ -254,7 +553,11 @@ public:
      */
     void setMaxHoldMS (const juce::int64 millis)
     {
-        holdMSecs = millis;
+        static_assert (hasHold, "This source has no LevelMeterMetrics::Hold");
+        Command command;
+        command.type = Command::SetHold;
+        command.hold = millis;
+        sendCommand (command);
     }
 
     /**
@@ -263,8 +566,11 @@ public:
      */
     float getReductionLevel (const int channel) const
     {
-        if (juce::isPositiveAndBelow (channel, static_cast<int> (levels.size ())))
-            return levels [size_t (channel)].reduction;
+        static_assert (hasReduction, "This source has no LevelMeterMetrics::Reduction");
+        ScopedStorage storage (*this);
+        const auto& levelData = storage->channels;
+        if (juce::isPositiveAndBelow (channel, static_cast<int> (levelData.size ())))
+            return levelData [size_t (channel)].reduction;
 
         return -1.0f;
     }
@@ -275,7 +581,8 @@ public:
      */
     float getMaxLevel (const int channel) const
     {
-        return levels.at (size_t (channel)).max;
+        static_assert (hasPeak, "This source has no LevelMeterMetrics::Peak");
+        return ScopedStorage (*this)->channels.at (size_t (channel)).max;
     }
 
     /**
@@ -284,7 +591,8 @@ public:
      */
     float getMaxOverallLevel (const int channel) const
     {
-        return levels.at (size_t (channel)).maxOverall;
+        static_assert (hasPeak, "This source has no LevelMeterMetrics::Peak");
+        return ScopedStorage (*this)->channels.at (size_t (channel)).maxOverall;
     }
 
     /**
@@ -293,7 +601,8 @@ public:
      */
     float getRMSLevel (const int channel) const
     {
-        return levels.at (size_t (channel)).getAvgRMS();
+        static_assert (hasRMS, "This source has no LevelMeterMetrics::RMS");
+        return ScopedStorage (*this)->channels.at (size_t (channel)).getAvgRMS();
     }
 
     /**
@@ -301,7 +610,35 @@ public:
      */
     bool getClipFlag (const int channel) const
     {
-        return levels.at (size_t (channel)).clip;
+        static_assert (hasClip, "This source has no LevelMeterMetrics::Clip");
+        return ScopedStorage (*this)->channels.at (size_t (channel)).clip;
+    }
+
+    /**
+     Returns the number of blocks, that clipped since the clip flag was cleared.
+     */
+    int getNumClips (const int channel) const
+    {
+        static_assert (hasClip, "This source has no LevelMeterMetrics::Clip");
+        return static_cast<int> (ScopedStorage (*this)->channels.at (size_t (channel)).numClips.load());
+    }
+
+    /**
+     Returns the estimated inter sample peak of the last block, \see LevelMeterMetrics::TruePeak
+     */
+    float getTruePeakLevel (const int channel) const
+    {
+        static_assert (hasTruePeak, "This source has no LevelMeterMetrics::TruePeak");
+        return ScopedStorage (*this)->channels.at (size_t (channel)).truePeak;
+    }
+
+    /**
+     Returns the highest estimated inter sample peak. It will stay up until \see clearMaxNum was called.
+     */
+    float getMaxTruePeakLevel (const int channel) const
+    {
+        static_assert (hasTruePeak, "This source has no LevelMeterMetrics::TruePeak");
+        return ScopedStorage (*this)->channels.at (size_t (channel)).maxTruePeak;
     }
 
     /**
@@ -309,14 +646,19 @@ public:
      */
     void clearClipFlag (const int channel)
     {
-        levels.at (size_t (channel)).clip = false;
+        static_assert (hasClip, "This source has no LevelMeterMetrics::Clip");
+        Command command;
+        command.type    = Command::ClearClip;
+        command.channel = channel;
+        sendCommand (command);
     }
 
     void clearAllClipFlags ()
     {
-        for (ChannelData& l : levels) {
-            l.clip = false;
-        }
+        static_assert (hasClip, "This source has no LevelMeterMetrics::Clip");
+        Command command;
+        command.type = Command::ClearAllClips;
+        sendCommand (command);
     }
 
     /**
@@ -324,7 +666,10 @@ public:
      */
     void clearMaxNum (const int channel)
     {
-        levels.at (size_t (channel)).maxOverall = infinity;
+        Command command;
+        command.type    = Command::ClearMaxNum;
+        command.channel = channel;
+        sendCommand (command);
     }
 
     /**
@@ -332,54 +677,620 @@ public:
      */
     void clearAllMaxNums ()
     {
-        for (ChannelData& l : levels) {
-            l.maxOverall = infinity;
-        }
+        Command command;
+        command.type = Command::ClearAllMaxNums;
+        sendCommand (command);
     }
 
     /**
-     Get the number of channels to be displayed
+     Get the number of channels to be displayed, including the aggregates
      */
     int getNumChannels () const
     {
-        return static_cast<int> (levels.size());
+        return static_cast<int> (ScopedStorage (*this)->channels.size());
+    }
+
+    /**
+     Returns a bit for each channel, that had a signal above the silence floor in the last block.
+     Bit 0 is the channel group * 64, so 64 channels are read with one atomic load.
+     */
+    juce::uint64 getActivityMask (const int group = 0) const
+    {
+        ScopedStorage storage (*this);
+        const auto& activity = storage->activity;
+        if (juce::isPositiveAndBelow (group, static_cast<int> (activity.size())))
+            return activity [size_t (group)].load (std::memory_order_relaxed);
+
+        return 0;
+    }
+
+    bool isChannelActive (const int channel) const
+    {
+        return channel >= 0 && (getActivityMask (channel / 64) & (juce::uint64 (1) << (channel % 64))) != 0;
+    }
+
+    /**
+     Blocks, where all samples stay below this level, are not scanned. The readings of the
+     channel only fall until they are settled, and the channel is reported as not active.
+     */
+    void setSilenceFloor (const float decibels)
+    {
+        silenceFloor = juce::Decibels::decibelsToGain (decibels);
+    }
+
+    /**
+     Get the number of input channels. The aggregates follow after them.
+     */
+    int getNumInputChannels () const
+    {
+        return ScopedStorage (*this)->numInputs;
     }
 
     /**
      The measure can be suspended, e.g. to save CPU when no meter is displayed.
-     In this case, the \see measureBlock will return immediately
+     In this case, the \see measureBlock will return immediately.
+     The LevelMeter and LevelMeterBridge register as consumers while they are showing, so the
+     measuring is also suspended automatically, \see getConsumers
      */
     void setSuspended (const bool shouldBeSuspended)
     {
         suspended = shouldBeSuspended;
     }
 
+    /**
+     Set the smallest change in decibels, that is considered visible. The GUI is only notified,
+     if a reading changed by more than that since the last notification.
+     */
+    void setDisplayThreshold (const float decibels)
+    {
+        displayRatio = juce::Decibels::decibelsToGain (std::abs (decibels));
+    }
+
+    /**
+     The generation is incremented each time the readings changed visibly. A consumer can compare
+     it with the last generation it displayed to decide, if it needs to repaint.
+     */
+    juce::uint32 getGeneration() const
+    {
+        return generation.load (std::memory_order_acquire);
+    }
+
+    /**
+     DEPRECATED: the flag is shared by all consumers, so the first one to reset it takes the new
+     data away from the others. Use a Cursor per consumer instead.
+     */
     bool checkNewDataFlag() const
     {
-        return newDataFlag;
+        return getGeneration() != consumedGeneration.load (std::memory_order_relaxed);
     }
 
+    /**
+     DEPRECATED: use a Cursor per consumer instead, \see checkNewDataFlag
+     */
     void resetNewDataFlag()
     {
-        newDataFlag = false;
+        consumedGeneration = getGeneration();
+    }
+
+    /**
+     Components displaying this source register here. If nobody is watching, the blocks
+     are skipped. It also counts the skipped blocks.
+     */
+    MeterConsumers& getConsumers()
+    {
+        return consumers;
+    }
+
+    const MeterConsumers& getConsumers() const
+    {
+        return consumers;
+    }
+
+    /**
+     Returns the number of blocks, that were not measured, because the GUI was applying commands
+     at the same time.
+     */
+    juce::int64 getNumDroppedBlocks() const
+    {
+        return droppedBlocks.load (std::memory_order_relaxed);
     }
 
 private:
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelMeterSource)
-    juce::WeakReference<LevelMeterSource>::Master masterReference;
-    friend class juce::WeakReference<LevelMeterSource>;
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BasicLevelMeterSource)
+    typename juce::WeakReference<BasicLevelMeterSource>::Master masterReference;
+    friend class juce::WeakReference<BasicLevelMeterSource>;
+
+    using RMSArena = typename LevelMeterMetrics::ArenaOf<typename LevelMeterMetrics::Find<LevelMeterMetrics::RMS, Metrics...>::type>::type;
+
+    /**
+     Everything, that is swapped in by resize. The RMS histories of all channels are
+     in the rmsArena, so it needs no allocation per channel.
+     */
+    using ReductionDelays = std::conditional_t<hasGainReduction, std::vector<float>, LevelMeterMetrics::Disabled<LevelMeterMetrics::GainReduction>>;
+
+    struct ChannelStorage
+    {
+        /** Builds the weight matrix with one row per aggregate and one column per input channel */
+        void setAggregates (const int numInputChannels, const std::vector<Aggregate>& aggregates)
+        {
+            numInputs = std::max (0, numInputChannels);
+            aggregateModes.clear();
+            aggregateWeights.assign (aggregates.size() * size_t (numInputs), 0.0f);
+
+            for (size_t a = 0; a < aggregates.size(); ++a)
+            {
+                const auto& weights = aggregates [a].weights;
+                for (size_t c = 0; c < size_t (numInputs); ++c)
+                    aggregateWeights [a * size_t (numInputs) + c] = weights.empty() ? 1.0f : (c < weights.size() ? weights [c] : 0.0f);
+
+                aggregateModes.push_back (aggregates [a].mode);
+            }
+
+            inputPeaks.assign (aggregates.empty() ? 0 : size_t (numInputs), 0.0f);
+            inputRMS.assign   (aggregates.empty() ? 0 : size_t (numInputs), 0.0f);
+
+            const auto numGroups = (size_t (numInputs) + aggregates.size() + 63) / 64;
+            activity        = std::vector<std::atomic<juce::uint64>> (numGroups);
+            pendingActivity = std::vector<std::atomic<juce::uint64>> (numGroups);
+        }
+
+        /** Channels of one word may be measured on different workers, hence the atomic or */
+        void setActive (const size_t channel)
+        {
+            pendingActivity [channel / 64].fetch_or (juce::uint64 (1) << (channel % 64), std::memory_order_relaxed);
+        }
+
+        std::vector<ChannelData>                channels;
+        RMSArena                                rmsArena;
+        ReductionDelays                         reductionDelays;
+        float                                   reductionSmoothing = 0.0f;
+
+        int                                     numInputs = 0;
+        std::vector<typename Aggregate::Mode>   aggregateModes;
+        std::vector<float>                      aggregateWeights;
+        std::vector<float>                      inputPeaks;
+        std::vector<float>                      inputRMS;
+
+        std::vector<std::atomic<juce::uint64>>  activity;
+        std::vector<std::atomic<juce::uint64>>  pendingActivity;
+    };
+
+    /**
+     A change from the GUI, that is applied by the audio thread between two blocks, so it
+     doesn't race with the read-modify-write of the levels.
+     */
+    struct Command
+    {
+        enum Type
+        {
+            ClearMaxNum = 0,
+            ClearAllMaxNums,
+            ClearClip,
+            ClearAllClips,
+            SetHold,
+            SwapStorage
+        };
+
+        Type            type    = ClearAllMaxNums;
+        int             channel = 0;
+        juce::int64     hold    = 0;
+        ChannelStorage* storage = nullptr;
+    };
+
+    /**
+     Pins the storage for a reader without the processing token, e.g. the GUI or setReductionLevel
+     on the audio thread. A retired storage is only freed while no reader is counted, so a reader,
+     that loaded it just before the swap, can finish.
+     */
+    class ScopedStorage
+    {
+    public:
+        explicit ScopedStorage (const BasicLevelMeterSource& ownerToUse)
+          : owner (ownerToUse)
+        {
+            // counting before loading pairs with swapping before checking the count in deleteRetiredStorage
+            ++owner.numReaders;
+            storage = owner.levels.load();
+        }
+
+        ~ScopedStorage()
+        {
+            --owner.numReaders;
+        }
+
+        ChannelStorage& operator*() const  { return *storage; }
+        ChannelStorage* operator->() const { return storage; }
+
+    private:
+        const BasicLevelMeterSource& owner;
+        ChannelStorage*              storage = nullptr;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedStorage)
+    };
+
+    /** Only for the owner of the processing token, nobody can swap the storage meanwhile */
+    std::vector<ChannelData>& getChannelData() const
+    {
+        return levels.load (std::memory_order_acquire)->channels;
+    }
+
+    /**
+     Queues the command for the audio thread. If the audio has stalled, e.g. before the playback
+     started, the command is applied right away on the calling thread. If the queue is full, the
+     caller waits for the processing token and applies all commands itself, so no command is lost.
+     The non realtime callers are serialised, so the commands have a single producer.
+     */
+    void sendCommand (const Command& command)
+    {
+        const std::lock_guard<std::mutex> lock (senderLock);
+        if (commands.push (command))
+        {
+            if (juce::Time::currentTimeMillis() - lastMeasurement >= 100 && tryToAcquireProcessing())
+            {
+                applyCommands();
+                releaseProcessing();
+            }
+        }
+        else
+        {
+            // the audio thread didn't pick up the commands for a long time. It only drops
+            // blocks while the token is held here, it never waits for it.
+            waitForProcessing();
+
+            // each swap retires a storage, so make room for them before applying
+            deleteRetiredStorage();
+            applyCommands();
+            deleteRetiredStorage();
+
+            // nobody else pushes, so this can't fail after the queue was emptied
+            commands.push (command);
+            applyCommands();
+            releaseProcessing();
+        }
+
+        deleteRetiredStorage();
+    }
+
+    /** Only called by the owner of the processing token */
+    void applyCommands()
+    {
+        if (commands.getNumReady() == 0)
+            return;
+
+        Command command;
+        while (commands.pop (command))
+        {
+            auto& levelData = getChannelData();
+            switch (command.type)
+            {
+                case Command::ClearMaxNum:
+                    if (juce::isPositiveAndBelow (command.channel, static_cast<int> (levelData.size())))
+                        clearMaxNum (levelData [size_t (command.channel)]);
+                    break;
+                case Command::ClearAllMaxNums:
+                    for (ChannelData& l : levelData)
+                        clearMaxNum (l);
+                    break;
+                case Command::ClearClip:
+                    if (juce::isPositiveAndBelow (command.channel, static_cast<int> (levelData.size())))
+                        clearClipFlag (levelData [size_t (command.channel)]);
+                    break;
+                case Command::ClearAllClips:
+                    for (ChannelData& l : levelData)
+                        clearClipFlag (l);
+                    break;
+                case Command::SetHold:
+                    holdMSecs = command.hold;
+                    break;
+                case Command::SwapStorage:
+                    // the old storage is freed by the non realtime side
+                    if (! retiredStorage.push (levels.exchange (command.storage)))
+                        jassertfalse;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        notifyNewData();
+    }
+
+    /**
+     Measures the input channels from begin to end. This may run on a worker of the
+     MeterWorkerPool, so it only touches the state of these channels.
+     */
+    template<typename FloatType>
+    bool measureChannels (ChannelStorage& storage, const juce::AudioBuffer<FloatType>& buffer, const juce::AudioBuffer<FloatType>* input,
+                          const int begin, const int end, const float ratio, const float floor)
+    {
+        const int numSamples = buffer.getNumSamples();
+        bool      changed    = false;
+
+        for (int channel = begin; channel < end; ++channel)
+        {
+            auto& level = storage.channels [size_t (channel)];
+            float magnitude = 0.0f;
+            float rms       = 0.0f;
+
+            // the scan for the silence gives the peak as well
+            const auto peak   = getPeak (buffer, channel, numSamples);
+            const bool silent = peak < floor
+                                && (input == nullptr || channel >= input->getNumChannels()
+                                    || getPeak (*input, channel, numSamples) < floor);
+
+            if (silent)
+            {
+                // nothing to scan, the readings only need to fall until they settle
+                if (! level.settled)
+                {
+                    level.setLevels (lastMeasurement, 0.0f, 0.0f, holdMSecs);
+
+                    if constexpr (hasGainReduction)
+                    {
+                        // keep the delay line and the envelopes running, so the first block after the silence is aligned
+                        const float reduction = level.reduction;
+                        if (input != nullptr && channel < input->getNumChannels())
+                            level.measureReduction (input->getReadPointer (channel), numSamples,
+                                                    float (buffer.getRMSLevel (channel, 0, numSamples)),
+                                                    storage.reductionSmoothing);
+
+                        level.reduction = reduction;
+                        level.releaseReduction (storage.reductionSmoothing);
+                    }
+
+                    const bool levelChanged = level.publishIfChanged (ratio);
+                    level.settled = ! levelChanged && level.isDecayed();
+                    changed = levelChanged || changed;
+                }
+            }
+            else
+            {
+                level.settled = false;
+                storage.setActive (size_t (channel));
+
+                if constexpr (hasPeak || hasClip)
+                    magnitude = peak;
+
+                if constexpr (hasRMS)
+                    rms = buffer.getRMSLevel (channel, 0, numSamples);
+
+                if constexpr (hasTruePeak)
+                    magnitude = std::max (magnitude, level.measure (buffer.getReadPointer (channel), numSamples));
+
+                level.setLevels (lastMeasurement, magnitude, rms, holdMSecs);
+
+                if constexpr (hasGainReduction)
+                {
+                    if (input != nullptr && channel < input->getNumChannels())
+                        level.measureReduction (input->getReadPointer (channel), numSamples,
+                                                hasRMS ? rms : float (buffer.getRMSLevel (channel, 0, numSamples)),
+                                                storage.reductionSmoothing);
+                }
+
+                changed = level.publishIfChanged (ratio) || changed;
+            }
+
+            if (! storage.aggregateModes.empty())
+            {
+                storage.inputPeaks [size_t (channel)] = magnitude;
+                storage.inputRMS   [size_t (channel)] = rms;
+            }
+        }
+
+        return changed;
+    }
+
+    template<typename FloatType>
+    bool measureAggregates (ChannelStorage& storage, const juce::AudioBuffer<FloatType>& buffer, const int numChannels, const float ratio, const float floor)
+    {
+        const auto numInputs = size_t (storage.numInputs);
+        bool changed = false;
+
+        for (size_t a = 0; a < storage.aggregateModes.size(); ++a)
+        {
+            const float* weights   = storage.aggregateWeights.data() + a * numInputs;
+            float        magnitude = 0.0f;
+            float        rms       = 0.0f;
+
+            if (storage.aggregateModes [a] == Aggregate::Downmix)
+            {
+                measureDownmix (buffer, weights, numChannels, magnitude, rms);
+            }
+            else
+            {
+                float power = 0.0f;
+                for (size_t c = 0; c < size_t (numChannels); ++c)
+                {
+                    magnitude = std::max (magnitude, weights [c] * storage.inputPeaks [c]);
+                    rms       = std::max (rms,       weights [c] * storage.inputRMS [c]);
+                    power    += juce::square (weights [c] * storage.inputRMS [c]);
+                }
+
+                if (storage.aggregateModes [a] == Aggregate::SumOfPowers)
+                    rms = std::sqrt (power);
+            }
+
+            if (magnitude > floor || rms > floor)
+                storage.setActive (numInputs + a);
+
+            auto& level = storage.channels [numInputs + a];
+            level.setLevels (lastMeasurement, magnitude, rms, holdMSecs);
+            changed = level.publishIfChanged (ratio) || changed;
+        }
+
+        return changed;
+    }
+
+    /**
+     The largest absolute sample of the block from one vectorised min/max scan. It is checked
+     against the silence floor and used as the magnitude, so the block isn't scanned twice.
+     */
+    template<typename FloatType>
+    static float getPeak (const juce::AudioBuffer<FloatType>& buffer, const int channel, const int numSamples)
+    {
+        const auto range = juce::FloatVectorOperations::findMinAndMax (buffer.getReadPointer (channel), numSamples);
+        return float (std::max (-range.getStart(), range.getEnd()));
+    }
+
+    /** Mixes the channels in small chunks on the stack, so the buffer is not copied */
+    template<typename FloatType>
+    static void measureDownmix (const juce::AudioBuffer<FloatType>& buffer, const float* weights, const int numChannels,
+                                float& magnitude, float& rms)
+    {
+        constexpr int chunkSize  = 64;
+        const int     numSamples = buffer.getNumSamples();
+        float         mix [chunkSize];
+        float         sum = 0.0f;
+
+        for (int start = 0; start < numSamples; start += chunkSize)
+        {
+            const int n = std::min (chunkSize, numSamples - start);
+            std::fill (mix, mix + n, 0.0f);
+
+            for (int c = 0; c < numChannels; ++c)
+            {
+                const float weight = weights [c];
+                if (weight == 0.0f)
+                    continue;
+
+                const auto* samples = buffer.getReadPointer (c, start);
+                for (int i = 0; i < n; ++i)
+                    mix [i] += weight * float (samples [i]);
+            }
+
+            for (int i = 0; i < n; ++i)
+            {
+                magnitude = std::max (magnitude, std::abs (mix [i]));
+                sum      += mix [i] * mix [i];
+            }
+        }
+
+        rms = numSamples > 0 ? std::sqrt (sum / float (numSamples)) : 0.0f;
+    }
+
+    static void clearMaxNum (ChannelData& level)
+    {
+        if constexpr (hasPeak)
+            level.maxOverall = infinity;
+
+        if constexpr (hasTruePeak)
+            level.maxTruePeak = 0.0f;
+
+        juce::ignoreUnused (level);
+    }
+
+    static void clearClipFlag (ChannelData& level)
+    {
+        if constexpr (hasClip)
+        {
+            level.clip     = false;
+            level.numClips = 0;
+        }
+
+        juce::ignoreUnused (level);
+    }
+
+    /**
+     Frees the storages retired by applyCommands, once no reader is counted. It is called with
+     the senderLock held, so the retiredStorage has a single consumer.
+     */
+    void deleteRetiredStorage()
+    {
+        ChannelStorage* storage = nullptr;
+        while (retiredStorage.pop (storage))
+            unusedStorage.push_back (storage);
+
+        if (unusedStorage.empty() || numReaders.load() > 0)
+            return;
+
+        for (auto* retired : unusedStorage)
+            delete retired;
+
+        unusedStorage.clear();
+    }
+
+    bool tryToAcquireProcessing()
+    {
+        if (processing.exchange (true, std::memory_order_acquire))
+        {
+            ++droppedBlocks;
+            return false;
+        }
+        return true;
+    }
+
+    /** Only for the non realtime side, e.g. when the command queue is full */
+    void waitForProcessing()
+    {
+        while (processing.exchange (true, std::memory_order_acquire))
+            juce::Thread::yield();
+    }
+
+    void releaseProcessing()
+    {
+        processing.store (false, std::memory_order_release);
+    }
 
     constexpr static float infinity = -100.0f;
 
-    std::vector<ChannelData> levels;
+    std::atomic<ChannelStorage*> levels { new ChannelStorage() };
+
+    LockFreeFifo<Command>         commands       { 64 };
+    LockFreeFifo<ChannelStorage*> retiredStorage { 64 };
+    std::mutex                    senderLock;
+    std::vector<ChannelStorage*>  unusedStorage;
+    mutable std::atomic<int>      numReaders     { 0 };
+    std::atomic<bool>             processing     { false };
+    std::atomic<juce::int64>      droppedBlocks  { 0 };
 
     juce::int64 holdMSecs;
 
+    // only used on the thread calling resize
+    int requestedChannels  = 0;
+    int requestedRMSWindow = 8;
+    int reductionLatency   = 0;
+    std::vector<Aggregate> requestedAggregates;
+
     std::atomic<juce::int64> lastMeasurement;
 
-    bool newDataFlag = true;
+    void notifyNewData()
+    {
+        generation.fetch_add (1, std::memory_order_release);
+    }
+
+    std::atomic<juce::uint32> generation         { 1 };
+    std::atomic<juce::uint32> consumedGeneration { 0 };
+    std::atomic<float>        displayRatio       { 1.0116f }; // 0.1 dB
+    std::atomic<float>        silenceFloor       { 1.0e-5f }; // -100 dB
+
+    std::atomic<bool>             suspended;
+    MeterConsumers                consumers;
+    std::atomic<MeterWorkerPool*> workerPool { nullptr };
+};
+
+/**
+ The LevelMeterSource with all metrics, that the LevelMeter displays. It is a class and not an
+ alias, so it can still be forward declared.
+ */
+class LevelMeterSource : public BasicLevelMeterSource<LevelMeterMetrics::Peak,
+                                                      LevelMeterMetrics::Hold,
+                                                      LevelMeterMetrics::RMS,
+                                                      LevelMeterMetrics::Clip,
+                                                      LevelMeterMetrics::GainReduction>
+{
+public:
+    LevelMeterSource() = default;
+
+    ~LevelMeterSource()
+    {
+        masterReference.clear();
+    }
+
+private:
+    juce::WeakReference<LevelMeterSource>::Master masterReference;
+    friend class juce::WeakReference<LevelMeterSource>;
 
-    bool suspended;
+    JUCE_LEAK_DETECTOR (LevelMeterSource)
 };
 
 /*@}*/
@@ -0,0 +1,373 @@
+/*
+ ==============================================================================
+ Copyright (c) 2017 - 2020 Foleys Finest Audio Ltd. - Daniel Walz
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+ 1. Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+ 3. Neither the name of the copyright holder nor the names of its contributors
+    may be used to endorse or promote products derived from this software without
+    specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ OF THE POSSIBILITY OF SUCH DAMAGE.
+ ==============================================================================
+
+
+    MeterRenderHarness.h
+    Author:  Daniel Walz
+
+ ==============================================================================
+*/
+
+#pragma once
+
+namespace foleys
+{
+
+/** @addtogroup ff_meters */
+/*@{*/
+
+/**
+ \class MeterRenderHarness
+ \brief Renders meters offscreen to measure the paint time and to compare against reference images
+
+ The harness paints LevelMeter and StereoFieldComponent directly into a juce::Image, so it doesn't
+ need a window or a display and can run in a console app on a build server. The meters are fed by
+ a deterministic signal before each frame. For each configuration in the matrix the frame times are
+ measured and each frame is compared against a PNG in the reference directory.
+
+ \code{.cpp}
+     int main()
+     {
+         juce::ScopedJuceInitialiser_GUI init;
+
+         foleys::MeterRenderHarness harness (juce::File ("meter_references"));
+         harness.addDefaultMatrix();
+         // harness.setWriteReferences (true);  // run once to create or update the references
+
+         auto results = harness.run();
+         std::cout << foleys::MeterRenderHarness::createReport (results);
+         return foleys::MeterRenderHarness::allPassed (results) ? 0 : 1;
+     }
+ \endcode
+ */
+class MeterRenderHarness
+{
+public:
+    /** One cell of the matrix. Set isStereoField to render a StereoFieldComponent instead of a LevelMeter */
+    struct Configuration
+    {
+        LevelMeter::MeterFlags flags         = LevelMeter::Default;
+        int                    numChannels   = 2;
+        int                    width         = 60;
+        int                    height        = 200;
+        bool                   isStereoField = false;
+
+        juce::String getName() const
+        {
+            if (isStereoField)
+                return "stereofield_" + juce::String (width) + "x" + juce::String (height);
+
+            return "meter_" + juce::String::toHexString (static_cast<int> (flags))
+                 + "_" + juce::String (numChannels) + "ch_" + juce::String (width) + "x" + juce::String (height);
+        }
+    };
+
+    struct Result
+    {
+        Configuration config;
+        int    numFrames           = 0;
+        double averageMilliseconds = 0.0;
+        double maxMilliseconds     = 0.0;
+        int    maxDifference       = 0;     /**< The largest difference of a colour component of a pixel in any frame */
+        float  differentPixels     = 0.0f;  /**< The largest fraction of pixels outside the tolerance in any frame */
+        bool   referencesMissing   = false;
+        bool   passed              = true;
+    };
+
+    MeterRenderHarness (const juce::File& referenceDirectoryToUse)
+      : referenceDirectory (referenceDirectoryToUse)
+    {
+    }
+
+    /** Adds a single configuration to the matrix */
+    void addConfiguration (const Configuration& config)
+    {
+        configurations.push_back (config);
+    }
+
+    /** Adds the common flag combinations with 1, 2 and 6 channels in a small and a large size, and two stereo fields */
+    void addDefaultMatrix()
+    {
+        const LevelMeter::MeterFlags flagsToTest[] = {
+            LevelMeter::Default,
+            LevelMeter::HasBorder,
+            LevelMeter::Horizontal,
+            LevelMeter::Minimal,
+            LevelMeter::Minimal | LevelMeter::Horizontal,
+            LevelMeter::Minimal | LevelMeter::MaxNumber,
+            LevelMeter::Reduction,
+            LevelMeter::SingleChannel | LevelMeter::HasBorder
+        };
+
+        for (auto flags : flagsToTest)
+        {
+            for (auto numChannels : { 1, 2, 6 })
+            {
+                for (auto size : { juce::Point<int> (30, 150), juce::Point<int> (120, 400) })
+                {
+                    Configuration config;
+                    config.flags       = flags;
+                    config.numChannels = numChannels;
+                    config.width       = (flags & LevelMeter::Horizontal) ? size.getY() : size.getX() * numChannels;
+                    config.height      = (flags & LevelMeter::Horizontal) ? size.getX() * numChannels : size.getY();
+                    addConfiguration (config);
+                }
+            }
+        }
+
+        for (auto size : { 150, 400 })
+        {
+            Configuration config;
+            config.isStereoField = true;
+            config.width         = size;
+            config.height        = size;
+            addConfiguration (config);
+        }
+    }
+
+    /** Set the number of frames to render per configuration. Each frame is compared against its own reference */
+    void setNumFrames (int newNumFrames)                    { numFrames = std::max (1, newNumFrames); }
+
+    /**
+     Set the tolerance for the comparison. A pixel is different, if any colour component differs by more
+     than maxComponentDifference. A frame passes, if not more than maxDifferentPixels (0.0 - 1.0) are different.
+     */
+    void setTolerance (int maxComponentDifference, float maxDifferentPixels)
+    {
+        componentTolerance = maxComponentDifference;
+        pixelTolerance     = maxDifferentPixels;
+    }
+
+    /** If set, the rendered frames are written as new references instead of being compared */
+    void setWriteReferences (bool shouldWrite)              { writeReferences = shouldWrite; }
+
+    /** Renders all configurations. If no LookAndFeel is given, a LevelMeterLookAndFeel is used */
+    std::vector<Result> run (juce::LookAndFeel* lookAndFeel = nullptr)
+    {
+        LevelMeterLookAndFeel defaultLookAndFeel;
+        if (lookAndFeel == nullptr)
+            lookAndFeel = &defaultLookAndFeel;
+
+        if (writeReferences)
+            referenceDirectory.createDirectory();
+
+        std::vector<Result> results;
+        for (const auto& config : configurations)
+            results.push_back (config.isStereoField ? runStereoField (config, *lookAndFeel)
+                                                    : runLevelMeter (config, *lookAndFeel));
+
+        return results;
+    }
+
+    /** Fills the buffer with a deterministic signal for that frame: decaying sines with a level per channel and a clip every few frames */
+    static void fillDeterministicSignal (juce::AudioBuffer<float>& buffer, int frame)
+    {
+        for (int channel=0; channel < buffer.getNumChannels(); ++channel)
+        {
+            auto* data = buffer.getWritePointer (channel);
+            const auto level = std::pow (0.7f, float ((frame + channel * 3) % 12))
+                             * ((frame + channel) % 17 == 0 ? 1.2f : 0.9f);
+            const auto omega = juce::MathConstants<float>::twoPi * float (channel + 1) / 64.0f;
+            for (int i=0; i < buffer.getNumSamples(); ++i)
+                data [i] = level * std::sin (omega * float (i) + float (channel));
+        }
+    }
+
+    /** Returns a table of the results, one line per configuration */
+    static juce::String createReport (const std::vector<Result>& results)
+    {
+        juce::String report;
+        for (const auto& result : results)
+        {
+            report << result.config.getName().paddedRight (' ', 36)
+                   << juce::String (result.averageMilliseconds, 3) << " ms avg  "
+                   << juce::String (result.maxMilliseconds, 3) << " ms max  "
+                   << "diff " << juce::String (result.differentPixels * 100.0f, 2) << "% (max " << juce::String (result.maxDifference) << ")  "
+                   << (result.referencesMissing ? "NO REFERENCE" : (result.passed ? "ok" : "FAILED")) << "\n";
+        }
+        return report;
+    }
+
+    static bool allPassed (const std::vector<Result>& results)
+    {
+        return std::all_of (results.begin(), results.end(), [] (const Result& r) { return r.passed && ! r.referencesMissing; });
+    }
+
+    /**
+     Compares two images. Returns the fraction of pixels, where a colour component differs by more than
+     the tolerance, and stores the largest difference in maxDifference. Images of different size are completely different.
+     */
+    static float compareImages (const juce::Image& a, const juce::Image& b, int tolerance, int& maxDifference)
+    {
+        maxDifference = 255;
+        if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight() || a.getWidth() * a.getHeight() == 0)
+            return 1.0f;
+
+        maxDifference = 0;
+        int numDifferent = 0;
+        const juce::Image::BitmapData dataA (a, juce::Image::BitmapData::readOnly);
+        const juce::Image::BitmapData dataB (b, juce::Image::BitmapData::readOnly);
+        for (int y=0; y < a.getHeight(); ++y)
+        {
+            for (int x=0; x < a.getWidth(); ++x)
+            {
+                const auto pa = dataA.getPixelColour (x, y);
+                const auto pb = dataB.getPixelColour (x, y);
+                const auto diff = std::max ({ std::abs (pa.getRed()   - pb.getRed()),
+                                              std::abs (pa.getGreen() - pb.getGreen()),
+                                              std::abs (pa.getBlue()  - pb.getBlue()),
+                                              std::abs (pa.getAlpha() - pb.getAlpha()) });
+                maxDifference = std::max (maxDifference, diff);
+                if (diff > tolerance)
+                    ++numDifferent;
+            }
+        }
+
+        return float (numDifferent) / float (a.getWidth() * a.getHeight());
+    }
+
+private:
+    Result runLevelMeter (const Configuration& config, juce::LookAndFeel& lookAndFeel)
+    {
+        LevelMeterSource source;
+        source.resize (config.numChannels, 4);
+        // the peak hold runs on wall clock time, make it long enough to be deterministic
+        source.setMaxHoldMS (std::numeric_limits<int>::max());
+
+        LevelMeter meter (config.flags);
+        meter.setLookAndFeel (&lookAndFeel);
+        meter.setSelectedChannel (0);
+        meter.setMeterSource (&source);
+        meter.setBounds (0, 0, config.width, config.height);
+
+        juce::AudioBuffer<float> buffer (config.numChannels, 512);
+        auto result = renderFrames (config, [&] (int frame)
+        {
+            fillDeterministicSignal (buffer, frame);
+            source.measureBlock (buffer);
+            source.setReductionLevel (0.5f + 0.05f * float (frame % 10));
+        },
+        [&] (juce::Graphics& g)
+        {
+            meter.paint (g);
+        });
+
+        meter.setLookAndFeel (nullptr);
+        return result;
+    }
+
+    Result runStereoField (const Configuration& config, juce::LookAndFeel& lookAndFeel)
+    {
+        StereoFieldBuffer<float> stereoBuffer;
+        stereoBuffer.setBufferSize (2, 2048);
+
+        StereoFieldComponent field (stereoBuffer);
+        field.setLookAndFeel (&lookAndFeel);
+        field.setBounds (0, 0, config.width, config.height);
+
+        juce::AudioBuffer<float> buffer (2, 512);
+        auto result = renderFrames (config, [&] (int frame)
+        {
+            fillDeterministicSignal (buffer, frame);
+            stereoBuffer.pushSampleBlock (buffer, buffer.getNumSamples());
+        },
+        [&] (juce::Graphics& g)
+        {
+            field.paint (g);
+        });
+
+        field.setLookAndFeel (nullptr);
+        return result;
+    }
+
+    /** Only the paint is timed, the signal of each frame is prepared and measured before */
+    template<typename PrepareFunction, typename PaintFunction>
+    Result renderFrames (const Configuration& config, PrepareFunction&& prepare, PaintFunction&& paint)
+    {
+        Result result;
+        result.config    = config;
+        result.numFrames = numFrames;
+
+        const auto ticksPerMs = double (juce::Time::getHighResolutionTicksPerSecond()) / 1000.0;
+        double total = 0.0;
+        for (int frame=0; frame < numFrames; ++frame)
+        {
+            prepare (frame);
+
+            juce::Image image (juce::Image::ARGB, config.width, config.height, true);
+            {
+                juce::Graphics g (image);
+                const auto start = juce::Time::getHighResolutionTicks();
+                paint (g);
+                const auto ms = double (juce::Time::getHighResolutionTicks() - start) / ticksPerMs;
+                total += ms;
+                result.maxMilliseconds = std::max (result.maxMilliseconds, ms);
+            }
+
+            const auto file = referenceDirectory.getChildFile (config.getName() + "_" + juce::String (frame) + ".png");
+            if (writeReferences)
+            {
+                file.deleteFile();
+                juce::FileOutputStream stream (file);
+                juce::PNGImageFormat png;
+                result.passed = stream.openedOk() && png.writeImageToStream (image, stream) && result.passed;
+                continue;
+            }
+
+            const auto reference = juce::ImageFileFormat::loadFrom (file);
+            if (! reference.isValid())
+            {
+                result.referencesMissing = true;
+                continue;
+            }
+
+            int maxDifference = 0;
+            const auto different = compareImages (image, reference, componentTolerance, maxDifference);
+            result.maxDifference   = std::max (result.maxDifference, maxDifference);
+            result.differentPixels = std::max (result.differentPixels, different);
+            if (different > pixelTolerance)
+                result.passed = false;
+        }
+
+        result.averageMilliseconds = total / numFrames;
+        return result;
+    }
+
+    juce::File                 referenceDirectory;
+    std::vector<Configuration> configurations;
+    int                        numFrames          = 8;
+    int                        componentTolerance = 8;
+    float                      pixelTolerance     = 0.002f;
+    bool                       writeReferences    = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MeterRenderHarness)
+};
+
+/*@}*/
+
+} // end namespace foleys
@@ -0,0 +1,309 @@
+/*
+ ==============================================================================
+ Copyright (c) 2017 - 2020 Foleys Finest Audio Ltd. - Daniel Walz
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+ 1. Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+ 3. Neither the name of the copyright holder nor the names of its contributors
+    may be used to endorse or promote products derived from this software without
+    specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ OF THE POSSIBILITY OF SUCH DAMAGE.
+ ==============================================================================
+
+
+    MeterScale.h
+    Author:  Daniel Walz
+
+ ==============================================================================
+*/
+
+#pragma once
+
+namespace foleys
+{
+
+/** @addtogroup ff_meters */
+/*@{*/
+
+/**
+ \class MeterScale
+ \brief Maps a gain to a position on a meter bar of a certain length
+
+ The scale law is given as breakpoints in decibels, between which the position is linear
+ in decibels. For the length of the bar a monotonic table of the gain thresholds for each
+ pixel is built once, so looking up a gain is a binary search without any logarithm.
+ Meters of the same size and law can share a scale, \see getShared.
+ */
+class MeterScale
+{
+public:
+    enum Law
+    {
+        LinearDecibels = 0, /**< Linear in decibels between minDecibels and maxDecibels */
+        IEC_60268_18,       /**< The scale of IEC 60268-18 from -70 dB to 0 dB */
+        K12,                /**< K-System with 0 dB at -12 dBFS, spanning 40 dB below that */
+        K14,                /**< K-System with 0 dB at -14 dBFS, spanning 40 dB below that */
+        K20,                /**< K-System with 0 dB at -20 dBFS, spanning 40 dB below that */
+        Custom              /**< A custom law defined by Breakpoints */
+    };
+
+    /** A point of the scale law. Between two breakpoints the position is linear in decibels */
+    struct Breakpoint
+    {
+        float decibels = 0.0f;
+        float position = 0.0f; /**< The position along the bar from 0.0 (bottom or left) to 1.0 (top or right) */
+    };
+
+    MeterScale (Law lawToUse, int lengthInPixels, float minDecibels = -100.0f, float maxDecibels = 0.0f)
+      : law (lawToUse),
+        length (std::max (0, lengthInPixels))
+    {
+        switch (law)
+        {
+            case IEC_60268_18:
+                breakpoints = { { -70.0f, 0.0f }, { -60.0f, 0.025f }, { -50.0f, 0.075f }, { -40.0f, 0.15f },
+                                { -30.0f, 0.3f }, { -20.0f, 0.5f },   { 0.0f, 1.0f } };
+                break;
+            case K12: breakpoints = { { -52.0f, 0.0f }, { 0.0f, 1.0f } }; reference = -12.0f; break;
+            case K14: breakpoints = { { -54.0f, 0.0f }, { 0.0f, 1.0f } }; reference = -14.0f; break;
+            case K20: breakpoints = { { -60.0f, 0.0f }, { 0.0f, 1.0f } }; reference = -20.0f; break;
+            case Custom:
+            case LinearDecibels:
+            default:
+                law = LinearDecibels;
+                breakpoints = { { minDecibels, 0.0f }, { maxDecibels, 1.0f } };
+                break;
+        }
+
+        build();
+    }
+
+    /**
+     Creates a custom law. The breakpoints need to be ascending in decibels and position.
+     */
+    MeterScale (std::vector<Breakpoint> customBreakpoints, int lengthInPixels)
+      : law (Custom),
+        length (std::max (0, lengthInPixels)),
+        breakpoints (std::move (customBreakpoints))
+    {
+        jassert (breakpoints.size() >= 2);
+        build();
+    }
+
+    /**
+     Returns the number of pixels from the bottom (or left) of the bar, that are covered by that gain.
+     This is a table lookup without any transcendental math.
+     */
+    int getPixelForGain (float gain) const
+    {
+        return static_cast<int> (std::upper_bound (thresholds.begin(), thresholds.end(), gain) - thresholds.begin());
+    }
+
+    /**
+     Returns the covered part of the bar from 0.0 to 1.0, quantised to the pixels of the table.
+     */
+    float getProportionForGain (float gain) const
+    {
+        return length > 0 ? float (getPixelForGain (gain)) / float (length) : 0.0f;
+    }
+
+    /**
+     Returns the position of a decibel value from 0.0 to 1.0, used e.g. to place the tick marks.
+     */
+    float getProportionForDecibels (float decibels) const
+    {
+        if (decibels <= breakpoints.front().decibels)
+            return breakpoints.front().position;
+
+        for (size_t i=1; i < breakpoints.size(); ++i)
+        {
+            const auto& lower = breakpoints [i - 1];
+            const auto& upper = breakpoints [i];
+            if (decibels <= upper.decibels)
+                return lower.position + (decibels - lower.decibels) * (upper.position - lower.position)
+                                        / (upper.decibels - lower.decibels);
+        }
+
+        return breakpoints.back().position;
+    }
+
+    /**
+     Returns the decibel values to put a labelled tick mark, from the top (or right) downwards.
+     */
+    std::vector<float> getTickDecibels () const
+    {
+        std::vector<float> ticks;
+        const auto top    = getMaxDecibels();
+        const auto bottom = getMinDecibels();
+
+        if (law == LinearDecibels)
+        {
+            const auto step = (top - bottom) * 0.1f;
+            for (int i=0; i <= 10; ++i)
+                ticks.push_back (top - i * step);
+        }
+        else if (law == IEC_60268_18)
+        {
+            ticks = { 0.0f, -5.0f, -10.0f, -15.0f, -20.0f, -30.0f, -40.0f, -50.0f, -60.0f, -70.0f };
+        }
+        else if (law == Custom)
+        {
+            for (auto it = breakpoints.rbegin(); it != breakpoints.rend(); ++it)
+                ticks.push_back (it->decibels);
+        }
+        else
+        {
+            // K-System: steps of 4 dB aligned to the reference level
+            const auto first = reference + 4.0f * std::floor ((top - reference) / 4.0f);
+            for (auto db = first; db >= bottom; db -= 4.0f)
+                ticks.push_back (db);
+        }
+
+        return ticks;
+    }
+
+    /**
+     Returns the text for a tick mark. The K-System scales read relative to their reference level,
+     so the reference is labelled 0. Apart from the Custom breakpoints, the ticks are labelled in
+     whole decibels, the steps of LinearDecibels are rounded.
+     */
+    juce::String getTickLabel (float decibels) const
+    {
+        if (law == Custom)
+            return juce::String (decibels);
+
+        if (law == K12 || law == K14 || law == K20)
+        {
+            const auto relative = juce::roundToInt (decibels - reference);
+            return relative > 0 ? "+" + juce::String (relative) : juce::String (relative);
+        }
+
+        return juce::String (juce::roundToInt (decibels));
+    }
+
+    /**
+     Returns the decibel values to put an unlabelled tick mark, halfway between the labelled ones.
+     */
+    std::vector<float> getMinorTickDecibels () const
+    {
+        const auto ticks = getTickDecibels();
+        std::vector<float> minor;
+        for (size_t i=1; i < ticks.size(); ++i)
+            minor.push_back ((ticks [i - 1] + ticks [i]) * 0.5f);
+
+        return minor;
+    }
+
+    Law   getLaw () const           { return law; }
+    int   getLength () const        { return length; }
+    float getMinDecibels () const   { return breakpoints.front().decibels; }
+    float getMaxDecibels () const   { return breakpoints.back().decibels; }
+
+    /**
+     For the K-System scales this is the level in dBFS, that reads as 0, otherwise the max decibels.
+     */
+    float getReferenceDecibels () const { return law == K12 || law == K14 || law == K20 ? reference : getMaxDecibels(); }
+
+    /**
+     Returns a scale, that is shared with all meters of the same law and size. It is only built,
+     if no such scale is in use already. A Custom law needs its breakpoints, so it can't be shared,
+     use the constructor with the breakpoints instead.
+     */
+    static std::shared_ptr<const MeterScale> getShared (Law law, int lengthInPixels,
+                                                        float minDecibels = -100.0f, float maxDecibels = 0.0f)
+    {
+        struct Key
+        {
+            Law law; int length; float minDecibels; float maxDecibels;
+            bool operator< (const Key& other) const
+            {
+                return std::tie (law, length, minDecibels, maxDecibels)
+                     < std::tie (other.law, other.length, other.minDecibels, other.maxDecibels);
+            }
+        };
+
+        static std::mutex lock;
+        static std::map<Key, std::weak_ptr<const MeterScale>> cache;
+
+        // a Custom law without breakpoints would have an empty range
+        jassert (law != Custom);
+        if (law == Custom)
+            law = LinearDecibels;
+
+        // the range is only relevant for the linear law
+        if (law != LinearDecibels)
+            minDecibels = maxDecibels = 0.0f;
+
+        const std::lock_guard<std::mutex> guard (lock);
+
+        auto& entry = cache [Key { law, lengthInPixels, minDecibels, maxDecibels }];
+        if (auto scale = entry.lock())
+            return scale;
+
+        auto scale = std::make_shared<const MeterScale> (law, lengthInPixels, minDecibels, maxDecibels);
+        entry = scale;
+
+        for (auto it = cache.begin(); it != cache.end();)
+            it = it->second.expired() ? cache.erase (it) : std::next (it);
+
+        return scale;
+    }
+
+private:
+    /** The inverse of getProportionForDecibels, only used to build the table */
+    float getDecibelsForProportion (float proportion) const
+    {
+        for (size_t i=1; i < breakpoints.size(); ++i)
+        {
+            const auto& lower = breakpoints [i - 1];
+            const auto& upper = breakpoints [i];
+            if (proportion <= upper.position && upper.position > lower.position)
+                return lower.decibels + (proportion - lower.position) * (upper.decibels - lower.decibels)
+                                        / (upper.position - lower.position);
+        }
+
+        return breakpoints.back().decibels;
+    }
+
+    void build ()
+    {
+        // a pixel is covered, if the gain reaches the centre of the pixel
+        thresholds.resize (size_t (length));
+        for (int i=0; i < length; ++i)
+        {
+            const auto proportion = (float (i) + 0.5f) / float (length);
+            const auto decibels   = getDecibelsForProportion (proportion);
+            thresholds [size_t (i)] = std::max (decibels > breakpoints.front().decibels
+                                                ? std::pow (10.0f, decibels * 0.05f) : 0.0f,
+                                                i > 0 ? thresholds [size_t (i - 1)] : 0.0f);
+        }
+    }
+
+    Law                     law       = LinearDecibels;
+    int                     length    = 0;
+    float                   reference = 0.0f;
+    std::vector<Breakpoint> breakpoints;
+    std::vector<float>      thresholds;
+
+    JUCE_LEAK_DETECTOR (MeterScale)
+};
+
+/*@}*/
+
+} // end namespace foleys
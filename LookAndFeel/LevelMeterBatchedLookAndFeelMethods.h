@@ -0,0 +1,228 @@
+/*
+ ==============================================================================
+ Copyright (c) 2017 - 2020 Foleys Finest Audio Ltd. - Daniel Walz
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+ 1. Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+ 3. Neither the name of the copyright holder nor the names of its contributors
+    may be used to endorse or promote products derived from this software without
+    specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ OF THE POSSIBILITY OF SUCH DAMAGE.
+ 
+ ==============================================================================
+
+    \file LevelMeterBatchedLookAndFeelMethods.h
+    Author:  Daniel Walz
+
+    To draw all channels of your LevelMeter in one call, inherit your LookAndFeel
+    class also from LevelMeter::BatchedLookAndFeelMethods and include this file
+    inside your class declaration in a public section, next to
+    LevelMeterLookAndFeelMethods.h.
+
+    The layout is computed using the placement callbacks of
+    LevelMeter::LookAndFeelMethods, so overriding them still has an effect.
+ ==============================================================================
+ */
+
+
+// include this file inside the implementation of your LookAndFeel to get the default implementation instead of copying it there
+
+void computeMeterLayout (foleys::LevelMeter::MeterLayout& layout,
+                         foleys::LevelMeter::MeterFlags meterType,
+                         juce::Rectangle<float> bounds,
+                         int numChannels,
+                         int fixedNumChannels,
+                         int selectedChannel) const override
+{
+    const juce::Rectangle<float> innerBounds = getMeterInnerBounds (bounds, meterType);
+    if (meterType & foleys::LevelMeter::Minimal)
+    {
+        if (meterType & foleys::LevelMeter::Horizontal)
+        {
+            const float height = innerBounds.getHeight() / (2 * numChannels - 1);
+            juce::Rectangle<float> meter = innerBounds.withHeight (height);
+            for (int channel=0; channel < numChannels; ++channel)
+            {
+                meter.setY (height * channel * 2);
+                const auto bar = getMeterBarBounds (meter, meterType);
+                layout.add (channel, bar,
+                            bar.withBottom (bar.getCentreY()),
+                            getMeterClipIndicatorBounds (meter, meterType),
+                            getMeterMaxNumberBounds (meter, meterType));
+            }
+        }
+        else
+        {
+            const float width = innerBounds.getWidth() / (2 * numChannels - 1);
+            juce::Rectangle<float> meter = innerBounds.withWidth (width);
+            for (int channel=0; channel < numChannels; ++channel)
+            {
+                meter.setX (width * channel * 2);
+                const auto bar = getMeterBarBounds (meter, meterType);
+                const auto column = innerBounds.withWidth (innerBounds.getWidth() / numChannels)
+                                               .withX (innerBounds.getX() + channel * (innerBounds.getWidth() / numChannels));
+                layout.add (channel, bar,
+                            bar.withLeft (bar.getCentreX()),
+                            getMeterClipIndicatorBounds (meter, meterType),
+                            getMeterMaxNumberBounds (column, meterType));
+            }
+        }
+    }
+    else if (meterType & foleys::LevelMeter::SingleChannel)
+    {
+        if (juce::isPositiveAndBelow (selectedChannel, numChannels))
+            addMeterChannelLayout (layout, meterType, innerBounds, selectedChannel);
+    }
+    else
+    {
+        const int numDrawnChannels = fixedNumChannels < 0 ? numChannels : fixedNumChannels;
+        for (int channel=0; channel < numChannels; ++channel)
+            addMeterChannelLayout (layout, meterType,
+                                   getMeterBounds (innerBounds, meterType, numDrawnChannels, channel),
+                                   channel);
+    }
+}
+
+void drawMeterBarsBatched (juce::Graphics& g,
+                           foleys::LevelMeter::MeterFlags meterType,
+                           const foleys::LevelMeter::MeterLayout& layout,
+                           const foleys::LevelMeter::MeterLevels& levels) override
+{
+    const int numChannels = std::min (layout.size(), levels.size());
+    if (numChannels == 0)
+        return;
+
+    const bool horizontal = meterType & foleys::LevelMeter::Horizontal;
+
+    // all bars have the same length, so they share the scale
+    const auto first  = getFlooredMeterBounds (layout.barBounds.front());
+    const auto length = juce::roundToInt (horizontal ? first.getWidth() : first.getHeight());
+
+    if (meterType & foleys::LevelMeter::Vintage)
+    {
+        // the vintage look is drawn per channel, so an implementation of drawMeterBar is used here too
+        for (size_t i=0; i < size_t (numChannels); ++i)
+            drawMeterBar (g, meterType, layout.barBounds [i], levels.rms [i], levels.peak [i]);
+    }
+    else if (meterType & foleys::LevelMeter::Reduction)
+    {
+        const auto scale = getMeterScale (meterType, length);
+        g.setColour (findColour (foleys::LevelMeter::lmMeterReductionColour));
+        for (size_t i=0; i < size_t (numChannels); ++i)
+            fillMeterReduction (g, horizontal, getFlooredMeterBounds (layout.barBounds [i]),
+                                float (scale->getPixelForGain (levels.reduction [i])));
+    }
+    else
+    {
+        static const auto peakVisible = juce::Decibels::decibelsToGain (-49.0f);
+        static const auto peakWarn    = juce::Decibels::decibelsToGain (-5.0f);
+        static const auto peakOver    = juce::Decibels::decibelsToGain (-0.3f);
+
+        const auto scale = getMeterScale (meterType, length);
+
+        // all bars share the same gradient, so the fill is only set once
+        g.setGradientFill (getMeterGradient (horizontal, first));
+        for (size_t i=0; i < size_t (numChannels); ++i)
+        {
+            const auto floored = getFlooredMeterBounds (layout.barBounds [i]);
+            const auto pixels  = float (scale->getPixelForGain (levels.rms [i]));
+            if (horizontal)
+                g.fillRect (floored.withRight (floored.getX() + pixels));
+            else
+                g.fillRect (floored.withTop (floored.getBottom() - pixels));
+        }
+
+        for (size_t i=0; i < size_t (numChannels); ++i)
+        {
+            const auto peak = levels.peak [i];
+            if (peak <= peakVisible)
+                continue;
+
+            const auto floored = getFlooredMeterBounds (layout.barBounds [i]);
+            const auto pixels  = float (scale->getPixelForGain (peak));
+            g.setColour (findColour ((peak > peakOver) ? foleys::LevelMeter::lmMeterMaxOverColour :
+                                     ((peak > peakWarn) ? foleys::LevelMeter::lmMeterMaxWarnColour :
+                                      foleys::LevelMeter::lmMeterMaxNormalColour)));
+            if (horizontal)
+                g.drawVerticalLine (juce::roundToInt (floored.getX() + pixels), floored.getY(), floored.getBottom());
+            else
+                g.drawHorizontalLine (juce::roundToInt (floored.getBottom() - pixels), floored.getX(), floored.getRight());
+        }
+
+        g.setColour (findColour (foleys::LevelMeter::lmMeterReductionColour));
+        for (size_t i=0; i < size_t (numChannels); ++i)
+        {
+            if (levels.reduction [i] >= 1.0f || layout.reductionBounds [i].isEmpty())
+                continue;
+
+            const auto floored = getFlooredMeterBounds (layout.reductionBounds [i]);
+            const auto reductionScale = getMeterScale (meterType | foleys::LevelMeter::Reduction,
+                                                       juce::roundToInt (horizontal ? floored.getWidth() : floored.getHeight()));
+            fillMeterReduction (g, horizontal, floored, float (reductionScale->getPixelForGain (levels.reduction [i])));
+        }
+    }
+
+    for (size_t i=0; i < size_t (numChannels); ++i)
+    {
+        const auto& clip = layout.clipBounds [i];
+        if (clip.isEmpty())
+            continue;
+
+        g.setColour (findColour (levels.clip [i] ? foleys::LevelMeter::lmBackgroundClipColour : foleys::LevelMeter::lmMeterBackgroundColour));
+        g.fillRect (clip);
+        g.setColour (findColour (foleys::LevelMeter::lmMeterOutlineColour));
+        g.drawRect (clip, 1.0);
+    }
+
+    for (size_t i=0; i < size_t (numChannels); ++i)
+    {
+        const auto& maxNum = layout.maxNumberBounds [i];
+        if (maxNum.isEmpty())
+            continue;
+
+        drawMaxNumber (g, meterType, maxNum,
+                       (meterType & foleys::LevelMeter::Reduction) ? levels.reduction [i] : levels.maxOverall [i]);
+    }
+}
+
+/** Adds the placement of one channel as used by drawMeterChannel */
+void addMeterChannelLayout (foleys::LevelMeter::MeterLayout& layout,
+                            foleys::LevelMeter::MeterFlags meterType,
+                            juce::Rectangle<float> bounds,
+                            int channel) const
+{
+    const auto bar = getMeterBarBounds (bounds, meterType);
+    juce::Rectangle<float> reduction;
+    if (! (meterType & foleys::LevelMeter::Reduction))
+        reduction = (meterType & foleys::LevelMeter::Horizontal) ? bar.withBottom (bar.getCentreY())
+                                                                 : bar.withLeft (bar.getCentreX());
+
+    layout.add (channel, bar, reduction,
+                getMeterClipIndicatorBounds (bounds, meterType),
+                getMeterMaxNumberBounds (bounds, meterType));
+}
+
+/** Fills the reduction from the top, the colour has to be set already */
+static void fillMeterReduction (juce::Graphics& g, bool horizontal, juce::Rectangle<float> floored, float pixels)
+{
+    if (horizontal)
+        g.fillRect (floored.withLeft (floored.getRight() - pixels));
+    else
+        g.fillRect (floored.withBottom (floored.getBottom() - pixels));
+}
@@ -62,7 +62,9 @@ class LevelMeterSource;
        };
    \endcode
 */
-class LevelMeterLookAndFeel : public juce::LookAndFeel_V3, public LevelMeter::LookAndFeelMethods, public StereoFieldComponent::LookAndFeelMethods
+class LevelMeterLookAndFeel : public juce::LookAndFeel_V3,
+                              public LevelMeter::LookAndFeelMethods,
+                              public StereoFieldComponent::LookAndFeelMethods
 {
 public:
     LevelMeterLookAndFeel ()
@@ -82,6 +84,25 @@ public:
 
 };
 
+/**
+   \class BatchedLevelMeterLookAndFeel
+   \brief LevelMeterLookAndFeel, that draws all channels of a LevelMeter in one call
+
+   The batched drawing doesn't call drawMeterBar, drawMeterReduction or drawClipIndicator, so
+   it is opt-in: overrides of those callbacks in a subclass of LevelMeterLookAndFeel keep working.
+   If you don't override them, use this class instead to get the faster drawing.
+*/
+class BatchedLevelMeterLookAndFeel : public LevelMeterLookAndFeel,
+                                     public LevelMeter::BatchedLookAndFeelMethods
+{
+public:
+    BatchedLevelMeterLookAndFeel() = default;
+
+    // include the batched drawing of all channels in one call
+    #include "LevelMeterBatchedLookAndFeelMethods.h"
+
+};
+
 /*@}*/
 
 } // end namespace foleys
@@ -555,71 +555,58 @@ void drawMeterBar (juce::Graphics& g,
                    juce::Rectangle<float> bounds,
                    float rms, float peak) override
 {
-    const auto infinity = meterType & foleys::LevelMeter::Reduction ? -30.0f :  -100.0f;
-    const auto rmsDb  = juce::Decibels::gainToDecibels (rms,  infinity);
-    const auto peakDb = juce::Decibels::gainToDecibels (peak, infinity);
+    const auto floored = getFlooredMeterBounds (bounds);
 
-    const juce::Rectangle<float> floored (ceilf (bounds.getX()) + 1.0f, ceilf (bounds.getY()) + 1.0f,
-                                          floorf (bounds.getRight()) - (ceilf (bounds.getX() + 2.0f)),
-                                          floorf (bounds.getBottom()) - (ceilf (bounds.getY()) + 2.0f));
+    const bool  horizontal = meterType & foleys::LevelMeter::Horizontal;
+    const auto  scale      = getMeterScale (meterType, juce::roundToInt (horizontal ? floored.getWidth() : floored.getHeight()));
 
     if (meterType & foleys::LevelMeter::Vintage) {
         // TODO
     }
     else if (meterType & foleys::LevelMeter::Reduction)
     {
-        const float limitDb = juce::Decibels::gainToDecibels (rms, infinity);
+        const auto limit = float (scale->getPixelForGain (rms));
         g.setColour (findColour (foleys::LevelMeter::lmMeterReductionColour));
-        if (meterType & foleys::LevelMeter::Horizontal)
-            g.fillRect (floored.withLeft (floored.getX() + limitDb * floored.getWidth() / infinity));
+        if (horizontal)
+            g.fillRect (floored.withLeft (floored.getRight() - limit));
         else
-            g.fillRect (floored.withBottom (floored.getY() + limitDb * floored.getHeight() / infinity));
+            g.fillRect (floored.withBottom (floored.getBottom() - limit));
     }
     else
     {
-        if (meterType & foleys::LevelMeter::Horizontal)
+        // the thresholds for the peak colours are only converted once
+        static const auto peakVisible = juce::Decibels::decibelsToGain (-49.0f);
+        static const auto peakWarn    = juce::Decibels::decibelsToGain (-5.0f);
+        static const auto peakOver    = juce::Decibels::decibelsToGain (-0.3f);
+
+        const auto rmsPixels  = float (scale->getPixelForGain (rms));
+        const auto peakPixels = float (scale->getPixelForGain (peak));
+
+        g.setGradientFill (getMeterGradient (horizontal, floored));
+
+        if (horizontal)
         {
-            if (horizontalGradient.getNumColours() < 2)
-            {
-                horizontalGradient = juce::ColourGradient (findColour (foleys::LevelMeter::lmMeterGradientLowColour),
-                                                           floored.getX(), floored.getY(),
-                                                           findColour (foleys::LevelMeter::lmMeterGradientMaxColour),
-                                                           floored.getRight(), floored.getY(), false);
-                horizontalGradient.addColour (0.5, findColour (foleys::LevelMeter::lmMeterGradientLowColour));
-                horizontalGradient.addColour (0.75, findColour (foleys::LevelMeter::lmMeterGradientMidColour));
-            }
-            g.setGradientFill (horizontalGradient);
-            g.fillRect (floored.withRight (floored.getRight() - rmsDb * floored.getWidth() / infinity));
+            g.fillRect (floored.withRight (floored.getX() + rmsPixels));
 
-            if (peakDb > -49.0)
+            if (peak > peakVisible)
             {
-                g.setColour (findColour ((peakDb > -0.3f) ? foleys::LevelMeter::lmMeterMaxOverColour :
-                                         ((peakDb > -5.0) ? foleys::LevelMeter::lmMeterMaxWarnColour :
+                g.setColour (findColour ((peak > peakOver) ? foleys::LevelMeter::lmMeterMaxOverColour :
+                                         ((peak > peakWarn) ? foleys::LevelMeter::lmMeterMaxWarnColour :
                                           foleys::LevelMeter::lmMeterMaxNormalColour)));
-                g.drawVerticalLine (juce::roundToInt (floored.getRight() - juce::jmax (peakDb * floored.getWidth() / infinity, 0.0f)),
+                g.drawVerticalLine (juce::roundToInt (floored.getX() + peakPixels),
                                     floored.getY(), floored.getBottom());
             }
         }
         else
         {
             // vertical
-            if (verticalGradient.getNumColours() < 2)
-            {
-                verticalGradient = juce::ColourGradient (findColour (foleys::LevelMeter::lmMeterGradientLowColour),
-                                                         floored.getX(), floored.getBottom(),
-                                                         findColour (foleys::LevelMeter::lmMeterGradientMaxColour),
-                                                         floored.getX(), floored.getY(), false);
-                verticalGradient.addColour (0.5f, findColour (foleys::LevelMeter::lmMeterGradientLowColour));
-                verticalGradient.addColour (0.75f, findColour (foleys::LevelMeter::lmMeterGradientMidColour));
-            }
-            g.setGradientFill (verticalGradient);
-            g.fillRect (floored.withTop (floored.getY() + rmsDb * floored.getHeight() / infinity));
+            g.fillRect (floored.withTop (floored.getBottom() - rmsPixels));
 
-            if (peakDb > -49.0f) {
-                g.setColour (findColour ((peakDb > -0.3f) ? foleys::LevelMeter::lmMeterMaxOverColour :
-                                         ((peakDb > -5.0f) ? foleys::LevelMeter::lmMeterMaxWarnColour :
+            if (peak > peakVisible) {
+                g.setColour (findColour ((peak > peakOver) ? foleys::LevelMeter::lmMeterMaxOverColour :
+                                         ((peak > peakWarn) ? foleys::LevelMeter::lmMeterMaxWarnColour :
                                           foleys::LevelMeter::lmMeterMaxNormalColour)));
-                g.drawHorizontalLine (juce::roundToInt (floored.getY() + juce::jmax (peakDb * floored.getHeight() / infinity, 0.0f)),
+                g.drawHorizontalLine (juce::roundToInt (floored.getBottom() - peakPixels),
                                       floored.getX(), floored.getRight());
             }
         }
@@ -631,19 +618,19 @@ void drawMeterReduction (juce::Graphics& g,
                          juce::Rectangle<float> bounds,
                          float reduction) override
 {
-    const auto infinity = -30.0f;
-    
-    const juce::Rectangle<float> floored (ceilf (bounds.getX()) + 1.0f, ceilf (bounds.getY()) + 1.0f,
-                                          floorf (bounds.getRight()) - (ceilf (bounds.getX() + 2.0f)),
-                                          floorf (bounds.getBottom()) - (ceilf (bounds.getY()) + 2.0f));
+    const auto floored = getFlooredMeterBounds (bounds);
+
+    const bool horizontal = meterType & foleys::LevelMeter::Horizontal;
+    const auto scale      = getMeterScale (meterType | foleys::LevelMeter::Reduction,
+                                           juce::roundToInt (horizontal ? floored.getWidth() : floored.getHeight()));
+    const auto limit      = float (scale->getPixelForGain (reduction));
 
-    const auto limitDb = juce::Decibels::gainToDecibels (reduction, infinity);
     g.setColour (findColour (foleys::LevelMeter::lmMeterReductionColour));
-    if (meterType & foleys::LevelMeter::Horizontal) {
-        g.fillRect (floored.withLeft (floored.getX() + limitDb * floored.getWidth() / infinity));
+    if (horizontal) {
+        g.fillRect (floored.withLeft (floored.getRight() - limit));
     }
     else {
-        g.fillRect (floored.withBottom (floored.getY() + limitDb * floored.getHeight() / infinity));
+        g.fillRect (floored.withBottom (floored.getBottom() - limit));
     }
 }
 
@@ -663,84 +650,73 @@ void drawTickMarks (juce::Graphics& g,
                     foleys::LevelMeter::MeterFlags meterType,
                     juce::Rectangle<float> bounds) override
 {
-    const auto infinity = meterType & foleys::LevelMeter::Reduction ? -30.0f :  -100.0f;
+    const bool horizontal = meterType & foleys::LevelMeter::Horizontal;
+    const auto length     = horizontal ? bounds.getWidth() : bounds.getHeight() - 2.0f;
+    const auto scale      = getMeterScale (meterType, juce::roundToInt (length));
 
     g.setColour (findColour (foleys::LevelMeter::lmTicksColour));
-    if (meterType & foleys::LevelMeter::Minimal)
+    if ((meterType & foleys::LevelMeter::Vintage) && ! (meterType & foleys::LevelMeter::Minimal))
     {
-        if (meterType & foleys::LevelMeter::Horizontal)
-        {
-            for (int i=0; i<11; ++i)
-                g.drawVerticalLine (juce::roundToInt (bounds.getX() + i * 0.1f * bounds.getWidth()),
-                                    bounds.getY() + 4,
-                                    bounds.getBottom() - 4);
-        }
-        else
+        // TODO
+    }
+    else if (horizontal)
+    {
+        for (auto db : scale->getTickDecibels())
+            g.drawVerticalLine (juce::roundToInt (bounds.getX() + scale->getProportionForDecibels (db) * length),
+                                bounds.getY() + 4,
+                                bounds.getBottom() - 4);
+    }
+    else if (meterType & foleys::LevelMeter::Minimal)
+    {
+        const auto h = length * 0.1f;
+        for (auto db : scale->getTickDecibels())
+            g.drawHorizontalLine (juce::roundToInt (bounds.getY() + (1.0f - scale->getProportionForDecibels (db)) * length + 1),
+                                  bounds.getX() + 4,
+                                  bounds.getRight());
+
+        if (h > 10 && bounds.getWidth() > 20)
         {
-            const auto h = (bounds.getHeight() - 2.0f) * 0.1f;
-            for (int i=0; i<11; ++i)
-            {
-                g.drawHorizontalLine (juce::roundToInt (bounds.getY() + i * h + 1),
-                                      bounds.getX() + 4,
-                                      bounds.getRight());
-            }
-            if (h > 10 && bounds.getWidth() > 20)
+            // don't print tiny numbers
+            g.setFont (h * 0.5f);
+            for (auto db : scale->getTickDecibels())
             {
-                // don't print tiny numbers
-                g.setFont (h * 0.5f);
-                for (int i=0; i<10; ++i) {
-                    g.drawFittedText (juce::String (i * 0.1 * infinity),
-                                      juce::roundToInt (bounds.getX()),
-                                      juce::roundToInt (bounds.getY() + i * h + 2),
-                                      juce::roundToInt (bounds.getWidth()),
-                                      juce::roundToInt (h * 0.6f),
-                                      juce::Justification::centredTop, 1);
-                }
+                if (db <= scale->getMinDecibels())
+                    continue;
+
+                g.drawFittedText (scale->getTickLabel (db),
+                                  juce::roundToInt (bounds.getX()),
+                                  juce::roundToInt (bounds.getY() + (1.0f - scale->getProportionForDecibels (db)) * length + 2),
+                                  juce::roundToInt (bounds.getWidth()),
+                                  juce::roundToInt (h * 0.6f),
+                                  juce::Justification::centredTop, 1);
             }
         }
     }
-    else if (meterType & foleys::LevelMeter::Vintage)
-    {
-        // TODO
-    }
     else
     {
-        if (meterType & foleys::LevelMeter::Horizontal)
+        const auto h = length * 0.05f;
+        g.setFont (h * 0.8f);
+        for (auto db : scale->getTickDecibels())
         {
-            for (int i=0; i<11; ++i)
-                g.drawVerticalLine (juce::roundToInt (bounds.getX() + i * 0.1f * bounds.getWidth()),
-                                    bounds.getY() + 4,
-                                    bounds.getBottom() - 4);
-        }
-        else
-        {
-            const auto h = (bounds.getHeight() - 2.0f) * 0.05f;
-            g.setFont (h * 0.8f);
-            for (int i=0; i<21; ++i) {
-                const auto y = bounds.getY() + i * h;
-                if (i % 2 == 0)
-                {
-                    g.drawHorizontalLine (juce::roundToInt (y + 1),
-                                          bounds.getX() + 4,
-                                          bounds.getRight());
-                    if (i < 20)
-                    {
-                        g.drawFittedText (juce::String (i * 0.05 * infinity),
-                                          juce::roundToInt (bounds.getX()),
-                                          juce::roundToInt (y + 4),
-                                          juce::roundToInt (bounds.getWidth()),
-                                          juce::roundToInt (h * 0.6f),
-                                          juce::Justification::topRight, 1);
-                    }
-                }
-                else
-                {
-                    g.drawHorizontalLine (juce::roundToInt (y + 2),
-                                          bounds.getX() + 4,
-                                          bounds.getCentreX());
-                }
+            const auto y = bounds.getY() + (1.0f - scale->getProportionForDecibels (db)) * length;
+            g.drawHorizontalLine (juce::roundToInt (y + 1),
+                                  bounds.getX() + 4,
+                                  bounds.getRight());
+            if (db > scale->getMinDecibels())
+            {
+                g.drawFittedText (scale->getTickLabel (db),
+                                  juce::roundToInt (bounds.getX()),
+                                  juce::roundToInt (y + 4),
+                                  juce::roundToInt (bounds.getWidth()),
+                                  juce::roundToInt (h * 0.6f),
+                                  juce::Justification::topRight, 1);
             }
         }
+
+        for (auto db : scale->getMinorTickDecibels())
+            g.drawHorizontalLine (juce::roundToInt (bounds.getY() + (1.0f - scale->getProportionForDecibels (db)) * length + 2),
+                                  bounds.getX() + 4,
+                                  bounds.getCentreX());
     }
 }
 
@@ -834,9 +810,86 @@ int hitTestMaxNumber (juce::Point<int> position,
     return -1;
 }
 
+/**
+ Set the law of the scale used for the level bars and tick marks. The reduction is always
+ displayed linear in decibels down to -30 dB.
+ */
+void setMeterScaleLaw (foleys::MeterScale::Law law, float minDecibels = -100.0f)
+{
+    meterScaleLaw         = law;
+    meterScaleMinDecibels = minDecibels;
+    levelMeterScales.clear();
+}
+
+/**
+ Returns the scale for a meter bar of that length. The scales are kept for each length, so meters
+ of different sizes and the tick marks sharing this LookAndFeel don't rebuild them. A scale is
+ only built, when a meter is resized to a new length.
+ */
+std::shared_ptr<const foleys::MeterScale> getMeterScale (foleys::LevelMeter::MeterFlags meterType, int length) const
+{
+    const bool reduction = meterType & foleys::LevelMeter::Reduction;
+    auto&      scales    = reduction ? reductionMeterScales : levelMeterScales;
+
+    const auto known = scales.find (length);
+    if (known != scales.end())
+        return known->second;
+
+    // dragging the window size creates many lengths, that are never used again
+    if (scales.size() >= 32)
+        scales.clear();
+
+    auto scale = reduction ? foleys::MeterScale::getShared (foleys::MeterScale::LinearDecibels, length, -30.0f)
+                           : foleys::MeterScale::getShared (meterScaleLaw, length, meterScaleMinDecibels);
+    scales [length] = scale;
+    return scale;
+}
+
+/** The area inside the outline of a meter bar, aligned to whole pixels */
+static juce::Rectangle<float> getFlooredMeterBounds (juce::Rectangle<float> bounds)
+{
+    return { ceilf (bounds.getX()) + 1.0f, ceilf (bounds.getY()) + 1.0f,
+             floorf (bounds.getRight()) - (ceilf (bounds.getX()) + 2.0f),
+             floorf (bounds.getBottom()) - (ceilf (bounds.getY()) + 2.0f) };
+}
+
+/** Returns the cached gradient for the meter bars, creating it if the colours were updated */
+const juce::ColourGradient& getMeterGradient (bool horizontal, juce::Rectangle<float> floored)
+{
+    if (horizontal)
+    {
+        if (horizontalGradient.getNumColours() < 2)
+        {
+            horizontalGradient = juce::ColourGradient (findColour (foleys::LevelMeter::lmMeterGradientLowColour),
+                                                       floored.getX(), floored.getY(),
+                                                       findColour (foleys::LevelMeter::lmMeterGradientMaxColour),
+                                                       floored.getRight(), floored.getY(), false);
+            horizontalGradient.addColour (0.5, findColour (foleys::LevelMeter::lmMeterGradientLowColour));
+            horizontalGradient.addColour (0.75, findColour (foleys::LevelMeter::lmMeterGradientMidColour));
+        }
+        return horizontalGradient;
+    }
+
+    if (verticalGradient.getNumColours() < 2)
+    {
+        verticalGradient = juce::ColourGradient (findColour (foleys::LevelMeter::lmMeterGradientLowColour),
+                                                 floored.getX(), floored.getBottom(),
+                                                 findColour (foleys::LevelMeter::lmMeterGradientMaxColour),
+                                                 floored.getX(), floored.getY(), false);
+        verticalGradient.addColour (0.5f, findColour (foleys::LevelMeter::lmMeterGradientLowColour));
+        verticalGradient.addColour (0.75f, findColour (foleys::LevelMeter::lmMeterGradientMidColour));
+    }
+    return verticalGradient;
+}
+
 private:
 
 juce::ColourGradient horizontalGradient;
 juce::ColourGradient verticalGradient;
 
+foleys::MeterScale::Law                                          meterScaleLaw         = foleys::MeterScale::LinearDecibels;
+float                                                            meterScaleMinDecibels = -100.0f;
+mutable std::map<int, std::shared_ptr<const foleys::MeterScale>> levelMeterScales;
+mutable std::map<int, std::shared_ptr<const foleys::MeterScale>> reductionMeterScales;
+
 
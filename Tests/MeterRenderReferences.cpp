@@ -0,0 +1,69 @@
+/*
+ ==============================================================================
+ Copyright (c) 2017 - 2020 Foleys Finest Audio Ltd. - Daniel Walz
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+ 1. Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+ 3. Neither the name of the copyright holder nor the names of its contributors
+    may be used to endorse or promote products derived from this software without
+    specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ OF THE POSSIBILITY OF SUCH DAMAGE.
+ ==============================================================================
+
+
+    MeterRenderReferences.cpp
+    Author:  Daniel Walz
+
+ ==============================================================================
+*/
+
+/*
+ Renders the default matrix of the MeterRenderHarness and compares each frame against the
+ PNGs in Tests/References. It fails, if a frame differs or a reference is missing.
+
+ Call it with --record to write the references, after a change of the looks was reviewed.
+ The fonts are rendered by the platform, so record and compare on the same build image.
+ */
+
+#include "../ff_meters.h"
+
+#include <iostream>
+
+#ifndef FF_METERS_REFERENCE_DIR
+#define FF_METERS_REFERENCE_DIR "References"
+#endif
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI init;
+
+    juce::StringArray args (argv + 1, argc - 1);
+
+    foleys::MeterRenderHarness harness (juce::File (FF_METERS_REFERENCE_DIR));
+    harness.addDefaultMatrix();
+    harness.setWriteReferences (args.contains ("--record"));
+
+    const auto results = harness.run();
+    std::cout << foleys::MeterRenderHarness::createReport (results);
+
+    if (args.contains ("--record"))
+        return 0;
+
+    return foleys::MeterRenderHarness::allPassed (results) ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+/*
+ ==============================================================================
+ Copyright (c) 2017 - 2020 Foleys Finest Audio Ltd. - Daniel Walz
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+ 1. Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+ 3. Neither the name of the copyright holder nor the names of its contributors
+    may be used to endorse or promote products derived from this software without
+    specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ OF THE POSSIBILITY OF SUCH DAMAGE.
+ ==============================================================================
+
+
+    OutlineBufferStress.cpp
+    Author:  Daniel Walz
+
+ ==============================================================================
+*/
+
+/*
+ Runs the audio thread, two GUI readers and a resizing thread on one OutlineBuffer at the
+ same time. Build it with -DFF_METERS_TSAN=ON, ThreadSanitizer must not report anything.
+ It fails, if a reader sees a value outside of the pushed signal.
+ */
+
+#include "../ff_meters.h"
+
+#include <thread>
+#include <cstdio>
+
+int main()
+{
+    constexpr int maxChannels = 6;
+    constexpr int blockSize   = 100;
+
+    foleys::OutlineBuffer outline;
+    outline.setSize (4, 256);
+    outline.setSamplesPerBlock (32);
+
+    std::atomic<bool> stop    { false };
+    std::atomic<int>  errors  { 0 };
+    std::atomic<int>  pushes  { 0 };
+    std::atomic<int>  reads   { 0 };
+
+    std::thread audio ([&]
+    {
+        juce::AudioBuffer<float> buffer (maxChannels, blockSize);
+        for (int block = 0; ! stop; ++block)
+        {
+            for (int channel = 0; channel < maxChannels; ++channel)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.setSample (channel, i, std::sin (0.01f * float (block * blockSize + i + channel)));
+
+            // block lengths, that don't divide the samples per block, split the blocks
+            outline.pushBlock (buffer, 37 + block % 64);
+            ++pushes;
+        }
+    });
+
+    auto reader = [&]
+    {
+        foleys::OutlineBuffer::Columns columns;
+        juce::Path path;
+        while (! stop)
+        {
+            outline.getChannelColumns (columns, 1, 120, 500);
+            for (int i = 0; i < columns.size(); ++i)
+                if (columns.minValues [i] < -1.0f || columns.maxValues [i] > 1.0f || columns.minValues [i] > columns.maxValues [i])
+                    ++errors;
+
+            path.clear();
+            outline.getChannelOutline (path, { 0.0f, 0.0f, 300.0f, 100.0f }, 0, 1000, columns);
+
+            const auto range = outline.getChannelRange (3, 10, 50);
+            if (range.getStart() < -1.0f || range.getEnd() > 1.0f)
+                ++errors;
+
+            ++reads;
+        }
+    };
+
+    std::thread reader1 (reader);
+    std::thread reader2 (reader);
+
+    for (int i = 0; i < 200; ++i)
+    {
+        outline.setSize (1 + i % maxChannels, 64 + (i * 37) % 1000);
+
+        if (i % 7 == 0)
+            outline.setPyramidFactor (2 + i % 3);
+
+        if (i % 11 == 0)
+            outline.setSamplesPerBlock (16 + i % 50);
+
+        std::this_thread::sleep_for (std::chrono::milliseconds (2));
+    }
+
+    stop = true;
+    audio.join();
+    reader1.join();
+    reader2.join();
+
+    std::printf ("OutlineBufferStress: %d blocks pushed, %d reads, %d errors\n", pushes.load(), reads.load(), errors.load());
+    return errors == 0 && pushes > 0 && reads > 0 ? 0 : 1;
+}
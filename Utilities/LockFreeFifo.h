@@ -0,0 +1,99 @@
+/*
+ ==============================================================================
+ Copyright (c) 2017 - 2020 Foleys Finest Audio Ltd. - Daniel Walz
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+ 1. Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+ 3. Neither the name of the copyright holder nor the names of its contributors
+    may be used to endorse or promote products derived from this software without
+    specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ==============================================================================
+
+    LockFreeFifo.h
+    Author:  Daniel Walz
+
+ ==============================================================================
+*/
+
+#pragma once
+
+namespace foleys
+{
+
+/** @addtogroup ff_meters */
+/*@{*/
+
+/**
+ \class LockFreeFifo
+
+ A wait-free single producer single consumer queue of copyable items with a fixed capacity.
+ All memory is allocated in the constructor, so push and pop are safe to call from the
+ audio thread.
+ */
+template<typename ItemType>
+class LockFreeFifo
+{
+public:
+    explicit LockFreeFifo (int capacity)
+      : fifo (capacity + 1),
+        items (size_t (capacity + 1))
+    {
+    }
+
+    /** Adds an item. Returns false, if the queue is full */
+    bool push (const ItemType& item)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (1, start1, size1, start2, size2);
+        if (size1 + size2 < 1)
+            return false;
+
+        items [size_t (size1 > 0 ? start1 : start2)] = item;
+        fifo.finishedWrite (1);
+        return true;
+    }
+
+    /** Takes the oldest item. Returns false, if the queue is empty */
+    bool pop (ItemType& item)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (1, start1, size1, start2, size2);
+        if (size1 + size2 < 1)
+            return false;
+
+        item = items [size_t (size1 > 0 ? start1 : start2)];
+        fifo.finishedRead (1);
+        return true;
+    }
+
+    int getNumReady() const    { return fifo.getNumReady(); }
+    int getFreeSpace() const   { return fifo.getFreeSpace(); }
+
+private:
+    juce::AbstractFifo    fifo;
+    std::vector<ItemType> items;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LockFreeFifo)
+};
+
+/*@}*/
+
+} // end namespace foleys
@@ -0,0 +1,214 @@
+/*
+ ==============================================================================
+ Copyright (c) 2017 - 2020 Foleys Finest Audio Ltd. - Daniel Walz
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+ 1. Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+ 3. Neither the name of the copyright holder nor the names of its contributors
+    may be used to endorse or promote products derived from this software without
+    specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ==============================================================================
+
+    MeterConsumers.h
+    Author:  Daniel Walz
+
+ ==============================================================================
+ */
+
+#pragma once
+
+namespace foleys
+{
+
+/** @addtogroup ff_meters */
+/*@{*/
+
+/**
+ \class MeterConsumers
+
+ Counts the components, that currently display the data of a source. The source asks
+ shouldProcess() for each block and skips its analysis, while nobody is watching.
+
+ Until the first consumer registered, the source keeps processing, so code that reads the
+ levels without registering keeps working. To opt out completely call setAutoSuspend (false).
+ */
+class MeterConsumers
+{
+public:
+    MeterConsumers() = default;
+
+    ~MeterConsumers()
+    {
+        masterReference.clear();
+    }
+
+    /**
+     A consumer holds a Registration and calls setInterested, whenever it is shown or hidden.
+     It unregisters itself when it is destroyed or pointed to different MeterConsumers.
+     */
+    class Registration
+    {
+    public:
+        Registration() = default;
+
+        Registration (Registration&& other) noexcept
+          : consumers  (other.consumers),
+            interested (other.interested)
+        {
+            other.consumers  = nullptr;
+            other.interested = false;
+        }
+
+        Registration& operator= (Registration&& other) noexcept
+        {
+            setInterested (false);
+            consumers  = other.consumers;
+            interested = other.interested;
+            other.consumers  = nullptr;
+            other.interested = false;
+            return *this;
+        }
+
+        ~Registration()
+        {
+            setInterested (false);
+        }
+
+        /** Moves an existing interest over to the new consumers */
+        void setConsumers (MeterConsumers* newConsumers)
+        {
+            if (consumers.get() == newConsumers)
+                return;
+
+            const bool wasInterested = interested;
+            setInterested (false);
+            consumers = newConsumers;
+            setInterested (wasInterested);
+        }
+
+        void setInterested (const bool shouldBeInterested)
+        {
+            if (interested == shouldBeInterested)
+                return;
+
+            interested = shouldBeInterested;
+            if (auto* c = consumers.get())
+            {
+                if (interested)
+                    c->addConsumer();
+                else
+                    c->removeConsumer();
+            }
+        }
+
+        bool isInterested() const { return interested; }
+
+    private:
+        juce::WeakReference<MeterConsumers> consumers;
+        bool                                interested = false;
+
+        JUCE_DECLARE_NON_COPYABLE (Registration)
+    };
+
+    void addConsumer()
+    {
+        tracked = true;
+        ++numConsumers;
+    }
+
+    void removeConsumer()
+    {
+        jassert (numConsumers > 0);
+        --numConsumers;
+    }
+
+    int getNumConsumers() const
+    {
+        return numConsumers.load();
+    }
+
+    /**
+     If switched off, the source is always processed, regardless of the consumers.
+     */
+    void setAutoSuspend (const bool shouldAutoSuspend)
+    {
+        autoSuspend = shouldAutoSuspend;
+    }
+
+    /**
+     Called by the source for each block on the audio thread. Returns false, if the block
+     can be skipped, because nobody is watching.
+     */
+    bool shouldProcess (const int numSamples)
+    {
+        if (! autoSuspend.load (std::memory_order_relaxed)
+            || ! tracked.load (std::memory_order_relaxed)
+            || numConsumers.load (std::memory_order_relaxed) > 0)
+            return true;
+
+        skipping = true;
+        skippedBlocks.fetch_add (1, std::memory_order_relaxed);
+        skippedSamples.fetch_add (numSamples, std::memory_order_relaxed);
+        return false;
+    }
+
+    /**
+     Returns true once after blocks were skipped. The source should then reset its running
+     state, so the consumers don't see readings from before the pause.
+     */
+    bool checkResumed()
+    {
+        if (! skipping)
+            return false;
+
+        skipping = false;
+        return true;
+    }
+
+    /** The number of blocks, that were not analysed since nobody was watching */
+    juce::int64 getNumSkippedBlocks() const
+    {
+        return skippedBlocks.load (std::memory_order_relaxed);
+    }
+
+    /** The number of samples, that were not analysed since nobody was watching */
+    juce::int64 getNumSkippedSamples() const
+    {
+        return skippedSamples.load (std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<int>         numConsumers   { 0 };
+    std::atomic<bool>        tracked        { false };
+    std::atomic<bool>        autoSuspend    { true };
+    std::atomic<juce::int64> skippedBlocks  { 0 };
+    std::atomic<juce::int64> skippedSamples { 0 };
+    bool                     skipping = false;
+
+    juce::WeakReference<MeterConsumers>::Master masterReference;
+    friend class juce::WeakReference<MeterConsumers>;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MeterConsumers)
+};
+
+/*@}*/
+
+} // end namespace foleys
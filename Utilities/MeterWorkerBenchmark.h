@@ -0,0 +1,194 @@
+/*
+ ==============================================================================
+ Copyright (c) 2017 - 2020 Foleys Finest Audio Ltd. - Daniel Walz
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+ 1. Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+ 3. Neither the name of the copyright holder nor the names of its contributors
+    may be used to endorse or promote products derived from this software without
+    specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+ ==============================================================================
+
+    MeterWorkerBenchmark.h
+    Author:  Daniel Walz
+
+ ==============================================================================
+*/
+
+#pragma once
+
+namespace foleys
+{
+
+/** @addtogroup ff_meters */
+/*@{*/
+
+/**
+ \class MeterWorkerBenchmark
+ \brief Compares the serial and the parallel measuring to find the crossover of a MeterWorkerPool
+
+ For each channel count the same buffer is measured serially on the calling thread and split
+ across the pool. The crossover depends on the machine, the block size and the number of
+ workers, so calibrate the pool on the target machine, e.g. once at startup:
+
+ \code{.cpp}
+     foleys::MeterWorkerPool pool;
+
+     auto results = foleys::MeterWorkerBenchmark::calibrate (pool, samplesPerBlock);
+     DBG (foleys::MeterWorkerBenchmark::createReport (results));
+
+     meterSource.setWorkerPool (&pool);
+ \endcode
+ */
+class MeterWorkerBenchmark
+{
+public:
+    enum Subject
+    {
+        MeterSource = 0,    /**< LevelMeterSource::measureBlock */
+        Outline             /**< OutlineBuffer::pushBlock */
+    };
+
+    struct Result
+    {
+        Subject subject              = MeterSource;
+        int     numChannels          = 0;
+        int     numSamples           = 0;
+        double  serialMicroseconds   = 0.0;   /**< The average time per block */
+        double  parallelMicroseconds = 0.0;   /**< The average time per block */
+
+        double getSpeedup() const
+        {
+            return parallelMicroseconds > 0.0 ? serialMicroseconds / parallelMicroseconds : 0.0;
+        }
+    };
+
+    /** Measures numBlocks blocks for each channel count, serially and split across the pool */
+    static std::vector<Result> run (MeterWorkerPool& pool, Subject subject,
+                                    const std::vector<int>& channelCounts = { 2, 8, 16, 32, 64, 128, 256, 512 },
+                                    int numSamples = 512, int numBlocks = 500)
+    {
+        const auto minimumWorkload = pool.getMinimumWorkload();
+
+        std::vector<Result> results;
+        for (auto numChannels : channelCounts)
+        {
+            Result result;
+            result.subject     = subject;
+            result.numChannels = numChannels;
+            result.numSamples  = numSamples;
+
+            pool.setMinimumWorkload (std::numeric_limits<int>::max());
+            result.serialMicroseconds = measure (pool, subject, numChannels, numSamples, numBlocks);
+
+            pool.setMinimumWorkload (0);
+            result.parallelMicroseconds = measure (pool, subject, numChannels, numSamples, numBlocks);
+
+            results.push_back (result);
+        }
+
+        pool.setMinimumWorkload (minimumWorkload);
+        return results;
+    }
+
+    /**
+     Returns the smallest channel count, from which on the split was faster for all larger
+     channel counts, or -1, if splitting never paid off.
+     */
+    static int findCrossover (const std::vector<Result>& results)
+    {
+        int crossover = -1;
+        for (auto it = results.rbegin(); it != results.rend() && it->getSpeedup() > 1.0; ++it)
+            crossover = it->numChannels;
+
+        return crossover;
+    }
+
+    /**
+     Runs the benchmark for the LevelMeterSource and sets the minimum workload of the pool to
+     the crossover. If splitting never paid off, the pool is switched to always measure serially.
+     */
+    static std::vector<Result> calibrate (MeterWorkerPool& pool, int numSamples = 512)
+    {
+        auto results = run (pool, MeterSource, { 2, 8, 16, 32, 64, 128, 256, 512 }, numSamples);
+
+        const auto crossover = findCrossover (results);
+        pool.setMinimumWorkload (crossover > 0 ? crossover * numSamples : std::numeric_limits<int>::max());
+        return results;
+    }
+
+    /** Returns a table of the results, one line per channel count */
+    static juce::String createReport (const std::vector<Result>& results)
+    {
+        juce::String report;
+        for (const auto& result : results)
+        {
+            report << (result.subject == MeterSource ? "measureBlock " : "pushBlock    ")
+                   << juce::String (result.numChannels).paddedLeft (' ', 4) << " ch x " << juce::String (result.numSamples) << "  "
+                   << juce::String (result.serialMicroseconds, 1) << " us serial  "
+                   << juce::String (result.parallelMicroseconds, 1) << " us parallel  "
+                   << juce::String (result.getSpeedup(), 2) << "x\n";
+        }
+
+        const auto crossover = findCrossover (results);
+        report << "crossover: " << (crossover > 0 ? juce::String (crossover) + " channels" : juce::String ("none")) << "\n";
+        return report;
+    }
+
+private:
+    static double measure (MeterWorkerPool& pool, Subject subject, int numChannels, int numSamples, int numBlocks)
+    {
+        juce::AudioBuffer<float> buffer (numChannels, numSamples);
+        MeterRenderHarness::fillDeterministicSignal (buffer, 0);
+
+        LevelMeterSource source;
+        source.resize (numChannels, 8);
+        source.setWorkerPool (&pool);
+
+        OutlineBuffer outline;
+        outline.setSize (numChannels, 1024);
+        outline.setWorkerPool (&pool);
+
+        auto process = [&]
+        {
+            if (subject == MeterSource)
+                source.measureBlock (buffer);
+            else
+                outline.pushBlock (buffer, numSamples);
+        };
+
+        // applies the resize and wakes the workers up
+        for (int i = 0; i < 20; ++i)
+            process();
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (int i = 0; i < numBlocks; ++i)
+            process();
+
+        const auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+        return seconds * 1.0e6 / std::max (1, numBlocks);
+    }
+};
+
+/*@}*/
+
+} // end namespace foleys
@@ -0,0 +1,288 @@
+/*
+ ==============================================================================
+ Copyright (c) 2017 - 2020 Foleys Finest Audio Ltd. - Daniel Walz
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+ 1. Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+ 3. Neither the name of the copyright holder nor the names of its contributors
+    may be used to endorse or promote products derived from this software without
+    specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+ ==============================================================================
+
+    MeterWorkerPool.h
+    Author:  Daniel Walz
+
+ ==============================================================================
+*/
+
+#pragma once
+
+namespace foleys
+{
+
+/** @addtogroup ff_meters */
+/*@{*/
+
+/**
+ \class MeterWorkerPool
+
+ A small pool of realtime threads, that split the channels of a very wide buffer, e.g. a
+ 512 channel MADI or AES67 bus. Give the same pool to several sources with setWorkerPool().
+
+ For each block the audio thread publishes the channel range, takes part in the work itself
+ and waits on a lock-free barrier until all claimed ranges are done. It never waits for a
+ sleeping worker: chunks nobody picked up are measured by the audio thread. After a job the
+ workers spin for a few microseconds and then sleep, until the audio thread wakes them with
+ the next block, so they don't keep cores busy between the blocks.
+
+ Splitting only pays off for wide buffers. Below the minimum workload the channels are
+ measured serially on the audio thread. Find the crossover for your machine with
+ MeterWorkerBenchmark::calibrate().
+ */
+class MeterWorkerPool
+{
+public:
+    /**
+     Starts the workers. The audio thread always takes part, so numWorkers is the number of
+     additional threads. If pinToCores is set, each worker is bound to its own core, starting
+     with core 1. Only use it, if the audio thread is bound to core 0, otherwise a worker may
+     share the core with the audio thread and hold up the barrier.
+     */
+    explicit MeterWorkerPool (const int numWorkers = getDefaultNumWorkers(), const bool pinToCores = false)
+    {
+        const int numCpus = std::max (1, juce::SystemStats::getNumCpus());
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            auto worker = std::make_unique<Worker> (*this, pinToCores ? (i + 1) % numCpus : -1);
+            worker->start();
+            workers.push_back (std::move (worker));
+        }
+    }
+
+    ~MeterWorkerPool()
+    {
+        for (auto& worker : workers)
+        {
+            worker->signalThreadShouldExit();
+            worker->notify();
+        }
+
+        for (auto& worker : workers)
+            worker->stopThread (1000);
+    }
+
+    /** One worker less than physical cores, but not more than three */
+    static int getDefaultNumWorkers()
+    {
+        return juce::jlimit (0, 3, juce::SystemStats::getNumPhysicalCpus() - 1);
+    }
+
+    int getNumWorkers() const
+    {
+        return static_cast<int> (workers.size());
+    }
+
+    /**
+     Sets the number of channels times samples per block, from which on the channels are split.
+     Smaller blocks are measured serially, because waking the workers would cost more than it saves.
+     */
+    void setMinimumWorkload (const int channelSamples)
+    {
+        minimumWorkload = std::max (0, channelSamples);
+    }
+
+    int getMinimumWorkload() const
+    {
+        return minimumWorkload.load (std::memory_order_relaxed);
+    }
+
+    /** Returns true, if a block of that size would be split */
+    bool shouldSplit (const int numChannels, const int numSamples) const
+    {
+        return ! workers.empty()
+            && numChannels > 1
+            && juce::int64 (numChannels) * numSamples >= getMinimumWorkload();
+    }
+
+    /**
+     Calls function (begin, end) for ranges of channels, that cover 0 ... numChannels. The ranges
+     run in parallel, if the block is big enough and no other source is using the pool right now.
+     Otherwise the function is called once with the whole range on the calling thread.
+     The function must not touch state shared between channels.
+     \returns true, if the range was split
+     */
+    template<typename Function>
+    bool forEachChannelRange (const int numChannels, const int numSamples, Function&& function)
+    {
+        if (! shouldSplit (numChannels, numSamples) || busy.exchange (true, std::memory_order_acquire))
+        {
+            function (0, numChannels);
+            return false;
+        }
+
+        job.function    = &invoke<std::remove_reference_t<Function>>;
+        job.context     = std::addressof (function);
+        job.numChannels = numChannels;
+        completed.store (0, std::memory_order_relaxed);
+
+        const auto numChunks = std::min (numChannels, (getNumWorkers() + 1) * chunksPerThread);
+        const auto epoch     = (state.load (std::memory_order_relaxed) >> 32) + 1;
+        state.store ((epoch << 32) | (juce::uint64 (numChunks) << 16));
+
+        // only the workers, that went to sleep since the last block, need to be woken
+        for (auto& worker : workers)
+            if (worker->isSleeping())
+                worker->notify();
+
+        runChunks (epoch);
+
+        // the barrier: wait for the chunks, that were claimed by the workers
+        for (int spins = 0; completed.load (std::memory_order_acquire) < numChunks; ++spins)
+            if (spins > 64)
+                juce::Thread::yield();
+
+        busy.store (false, std::memory_order_release);
+        return true;
+    }
+
+private:
+    /**
+     The state packs the epoch of the block, the number of chunks and the next chunk to claim
+     into one word. Claiming a chunk with a compare-and-swap therefore fails for a block, that
+     is already finished, and the job can't change while a claimed chunk is running.
+     */
+    static juce::uint64 getEpoch     (const juce::uint64 s) { return s >> 32; }
+    static int          getNumChunks (const juce::uint64 s) { return int ((s >> 16) & 0xffff); }
+    static int          getNextChunk (const juce::uint64 s) { return int (s & 0xffff); }
+
+    /** Claims and runs chunks of that epoch, until there are none left */
+    void runChunks (const juce::uint64 epoch)
+    {
+        auto s = state.load (std::memory_order_acquire);
+        while (getEpoch (s) == epoch && getNextChunk (s) < getNumChunks (s))
+        {
+            if (! state.compare_exchange_weak (s, s + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+                continue;
+
+            const auto chunk     = getNextChunk (s);
+            const auto numChunks = getNumChunks (s);
+            job.function (job.context, job.numChannels * chunk / numChunks, job.numChannels * (chunk + 1) / numChunks);
+
+            completed.fetch_add (1, std::memory_order_release);
+            s = state.load (std::memory_order_acquire);
+        }
+    }
+
+    template<typename Function>
+    static void invoke (const void* context, const int begin, const int end)
+    {
+        (*static_cast<Function*> (const_cast<void*> (context))) (begin, end);
+    }
+
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker (MeterWorkerPool& ownerToUse, const int coreToUse)
+          : juce::Thread ("Meter worker"),
+            owner (ownerToUse),
+            core (coreToUse)
+        {
+        }
+
+        void start()
+        {
+           #if JUCE_VERSION >= 0x70003
+            startRealtimeThread (juce::Thread::RealtimeOptions{});
+           #else
+            startThread (10);
+           #endif
+        }
+
+        void run() override
+        {
+            if (core >= 0)
+                juce::Thread::setCurrentThreadAffinityMask (juce::uint32 (1) << (core % 32));
+
+            const auto spinTicks = juce::Time::secondsToHighResolutionTicks (spinMicroseconds * 1.0e-6);
+
+            auto lastEpoch = getEpoch (owner.state.load (std::memory_order_acquire));
+            auto lastJob   = juce::Time::getHighResolutionTicks();
+
+            while (! threadShouldExit())
+            {
+                const auto epoch = getEpoch (owner.state.load (std::memory_order_acquire));
+                if (epoch != lastEpoch)
+                {
+                    owner.runChunks (epoch);
+                    lastEpoch = epoch;
+                    lastJob   = juce::Time::getHighResolutionTicks();
+                }
+                else if (juce::Time::getHighResolutionTicks() - lastJob >= spinTicks)
+                {
+                    // announcing the sleep before checking the epoch again pairs with publishing the
+                    // block before checking isSleeping, so either we see the block or we get woken
+                    sleeping.store (true);
+                    if (getEpoch (owner.state.load()) == lastEpoch && ! threadShouldExit())
+                        wait (-1);
+
+                    sleeping.store (false);
+                    lastJob = juce::Time::getHighResolutionTicks();
+                }
+            }
+        }
+
+        bool isSleeping() const
+        {
+            return sleeping.load();
+        }
+
+    private:
+        MeterWorkerPool&  owner;
+        const int         core;
+        std::atomic<bool> sleeping { false };
+
+        JUCE_DECLARE_NON_COPYABLE (Worker)
+    };
+
+    struct Job
+    {
+        void (*function) (const void*, int, int) = nullptr;
+        const void* context                      = nullptr;
+        int         numChannels                  = 0;
+    };
+
+    static constexpr int    chunksPerThread  = 2;
+    static constexpr double spinMicroseconds = 20.0;
+
+    Job                                  job;
+    std::atomic<juce::uint64>            state           { 0 };
+    std::atomic<int>                     completed       { 0 };
+    std::atomic<bool>                    busy            { false };
+    std::atomic<int>                     minimumWorkload { 64 * 512 };
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MeterWorkerPool)
+};
+
+/*@}*/
+
+} // end namespace foleys
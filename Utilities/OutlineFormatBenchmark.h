@@ -0,0 +1,166 @@
+/*
+ ==============================================================================
+ Copyright (c) 2017 - 2020 Foleys Finest Audio Ltd. - Daniel Walz
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+ 1. Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+ 3. Neither the name of the copyright holder nor the names of its contributors
+    may be used to endorse or promote products derived from this software without
+    specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ==============================================================================
+
+    OutlineFormatBenchmark.h
+    Author:  Daniel Walz
+
+ ==============================================================================
+*/
+
+#pragma once
+
+namespace foleys
+{
+
+/** @addtogroup ff_meters */
+/*@{*/
+
+/**
+ \class OutlineFormatBenchmark
+ \brief Compares the quantised storage formats of the OutlineBuffer against Float32
+
+ The same signal is pushed into an OutlineBuffer of each OutlineBuffer::StorageFormat. The
+ columns of an outline are compared in pixels against the Float32 ones, as they would be drawn
+ by OutlineBuffer::addOutline, and the time to read them is measured:
+
+ \code{.cpp}
+     auto results = foleys::OutlineFormatBenchmark::run (1000, 200);
+     DBG (foleys::OutlineFormatBenchmark::createReport (results));
+ \endcode
+ */
+class OutlineFormatBenchmark
+{
+public:
+    struct Result
+    {
+        OutlineBuffer::StorageFormat format = OutlineBuffer::Float32;
+        int    bytesPerBlock       = 0;
+        float  maxErrorPixels      = 0.0f;   /**< The largest offset of a column against Float32 */
+        float  meanErrorPixels     = 0.0f;
+        float  differentColumns    = 0.0f;   /**< The part of the columns, that are off by half a pixel or more */
+        double outlineMicroseconds = 0.0;    /**< The average time to read the columns of one channel */
+    };
+
+    /**
+     Pushes numBlocks blocks of a signal from -37 dB to full scale and reads them as one outline
+     of width x height pixels, once zoomed out completely and once with one block per column.
+     */
+    static std::vector<Result> run (int width = 1000, int height = 200, int numBlocks = 65536, int numRepaints = 200)
+    {
+        std::vector<Result> results;
+        std::vector<std::unique_ptr<OutlineBuffer>> outlines;
+        for (auto format : { OutlineBuffer::Float32, OutlineBuffer::Int16, OutlineBuffer::Int8 })
+        {
+            auto outline = std::make_unique<OutlineBuffer>();
+            outline->setStorageFormat (format);
+            outline->setSamplesPerBlock (samplesPerBlock);
+            outline->setSize (1, numBlocks);
+            outline->getConsumers().setAutoSuspend (false);
+
+            juce::AudioBuffer<float> buffer (1, samplesPerBlock * blocksPerFrame);
+            for (int frame = 0; frame < numBlocks / blocksPerFrame; ++frame)
+            {
+                MeterRenderHarness::fillDeterministicSignal (buffer, frame);
+                outline->pushBlock (buffer, buffer.getNumSamples());
+            }
+
+            Result result;
+            result.format        = format;
+            result.bytesPerBlock = format == OutlineBuffer::Int8 ? 2 : (format == OutlineBuffer::Int16 ? 4 : 8);
+            results.push_back (result);
+            outlines.push_back (std::move (outline));
+        }
+
+        const auto pixelsPerUnit = float (height) * 0.35f;
+        OutlineBuffer::Columns reference;
+        OutlineBuffer::Columns columns;
+
+        for (size_t i = 0; i < outlines.size(); ++i)
+        {
+            auto& result = results [i];
+            int   numCompared = 0;
+            int   numDifferent = 0;
+            float sumOfErrors = 0.0f;
+
+            for (auto zoom : { numBlocks, width })
+            {
+                outlines.front()->getChannelColumns (reference, 0, width, zoom);
+
+                const auto start = juce::Time::getHighResolutionTicks();
+                for (int repaint = 0; repaint < numRepaints; ++repaint)
+                    outlines [i]->getChannelColumns (columns, 0, width, zoom);
+
+                const auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+                result.outlineMicroseconds += seconds * 1.0e6 / std::max (1, numRepaints) / 2.0;
+
+                for (int column = 0; column < columns.size(); ++column)
+                {
+                    for (auto error : { std::abs (columns.minValues [size_t (column)] - reference.minValues [size_t (column)]),
+                                        std::abs (columns.maxValues [size_t (column)] - reference.maxValues [size_t (column)]) })
+                    {
+                        const auto pixels = error * pixelsPerUnit;
+                        result.maxErrorPixels = std::max (result.maxErrorPixels, pixels);
+                        sumOfErrors  += pixels;
+                        numDifferent += pixels >= 0.5f ? 1 : 0;
+                        ++numCompared;
+                    }
+                }
+            }
+
+            result.meanErrorPixels  = sumOfErrors / float (std::max (1, numCompared));
+            result.differentColumns = float (numDifferent) / float (std::max (1, numCompared));
+        }
+
+        return results;
+    }
+
+    /** Returns a table of the results, one line per format */
+    static juce::String createReport (const std::vector<Result>& results)
+    {
+        juce::String report;
+        for (const auto& result : results)
+        {
+            report << (result.format == OutlineBuffer::Float32 ? "Float32 " : (result.format == OutlineBuffer::Int16 ? "Int16   " : "Int8    "))
+                   << juce::String (result.bytesPerBlock) << " bytes/block  "
+                   << juce::String (result.outlineMicroseconds, 1) << " us/outline  "
+                   << "max " << juce::String (result.maxErrorPixels, 2) << " px  "
+                   << "mean " << juce::String (result.meanErrorPixels, 3) << " px  "
+                   << juce::String (result.differentColumns * 100.0f, 2) << "% off by half a pixel\n";
+        }
+        return report;
+    }
+
+private:
+    static constexpr int samplesPerBlock = 64;
+    static constexpr int blocksPerFrame  = 8;
+};
+
+/*@}*/
+
+} // end namespace foleys
@@ -51,28 +51,114 @@ namespace foleys
      */
     class OutlineBuffer
     {
+    public:
+        /**
+         How min and max of each block are stored. The quantised formats pack min and max of a
+         block into one word. They take a half or a quarter of the memory of Float32, so long
+         histories of many channels stay in the cache. The min is rounded down and the max up, so
+         the outline never gets smaller, values beyond the headroom are clipped.
+         */
+        enum StorageFormat
+        {
+            Float32 = 0,    /**< 8 bytes per block, exact */
+            Int16,          /**< 4 bytes per block, 12 dB headroom, a step is 0.0005 */
+            Int8            /**< 2 bytes per block, 6 dB headroom, a step is 0.016, about a pixel for 60 pixels from the centre to full scale */
+        };
+
+        /**
+         Min and max per pixel column, filled by getChannelColumns. Keep one around and pass it
+         again for each repaint, it only allocates, when it needs more columns than before.
+         */
+        struct Columns
+        {
+            std::vector<float> minValues;
+            std::vector<float> maxValues;
+            std::vector<float> rmsValues;    /**< Only filled, if the RMS is enabled, see setRMSEnabled */
+
+            // the undecoded values of the quantised formats
+            std::vector<int>   fixedMin;
+            std::vector<int>   fixedMax;
+
+            void setSize (const int numColumns)
+            {
+                minValues.resize (size_t (std::max (0, numColumns)));
+                maxValues.resize (size_t (std::max (0, numColumns)));
+                rmsValues.resize (size_t (std::max (0, numColumns)));
+            }
 
+            int size() const
+            {
+                return static_cast<int> (minValues.size());
+            }
+        };
+
+    private:
         class ChannelData
         {
-            std::vector<float>           minBuffer;
-            std::vector<float>           maxBuffer;
-            std::atomic<size_t>          writePointer     {0};
+            /**
+             One level of the pyramid. Each entry holds min and max of blocksPerEntry blocks,
+             the level 0 one entry per block of samplesPerBlock samples. The entries are atomic,
+             so a reader racing with the audio thread gets old or new values, but never torn ones.
+             */
+            struct Level
+            {
+                std::vector<std::atomic<float>>        minBuffer;    // Float32
+                std::vector<std::atomic<float>>        maxBuffer;
+                std::vector<std::atomic<juce::uint32>> packed16;     // Int16
+                std::vector<std::atomic<juce::uint16>> packed8;      // Int8
+                std::vector<std::atomic<float>>        squares;      // the sum of the mean squares of the blocks, if the RMS is enabled
+                juce::int64                            blocksPerEntry = 1;
+                juce::int64                            numEntries     = 0;
+                float                                  pendingMin     = 0.0f;
+                float                                  pendingMax     = 0.0f;
+                float                                  pendingSquares = 0.0f;
+            };
+
+            std::vector<Level>           levels;
+            std::atomic<juce::int64>     numWritten      {0};
+            std::atomic<juce::int64>     historyOffset   {0};
+            float                        currentMin      = 0.0f;
+            float                        currentMax      = 0.0f;
+            float                        currentSquares  = 0.0f;
             int                          fraction        = 0;
             int                          samplesPerBlock = 128;
+            int                          factor          = 2;
+            StorageFormat                format          = Float32;
+            bool                         storeRMS        = false;
 
             JUCE_LEAK_DETECTOR (ChannelData)
         public:
-            ChannelData ()
+            /**
+             The index in the OutlineHistory minus the index here, updated by the history writer
+             after each copy.
+             */
+            void setHistoryOffset (const juce::int64 offset)   { historyOffset.store (offset, std::memory_order_release); }
+            juce::int64 getHistoryOffset() const              { return historyOffset.load (std::memory_order_acquire); }
+
+            /**
+             @param numBlocks is the number of values the buffer will store. Allow a little safety buffer, so you
+             don't write into the part, where it is currently read.
+             @param pyramidFactor is the decimation from one level of the pyramid to the next. Each level
+             covers the same time with pyramidFactor times less entries
+             @param numSamples is the number of samples per block
+             @param formatToUse is how min and max are stored
+             @param shouldStoreRMS adds the mean square of each block
+             */
+            ChannelData (const int numBlocks, const int pyramidFactor, const int numSamples, const StorageFormat formatToUse, const bool shouldStoreRMS)
+              : samplesPerBlock (std::max (1, numSamples)),
+                factor (std::max (2, pyramidFactor)),
+                format (formatToUse),
+                storeRMS (shouldStoreRMS)
             {
-                setSize (1024);
+                allocate (numBlocks);
             }
 
             /**
              This copy constructor does not really copy. It is only present to satisfy the vector.
              */
             ChannelData (const ChannelData& other)
+              : ChannelData (other.getSize(), other.factor, other.samplesPerBlock, other.format, other.storeRMS)
             {
-                setSize (other.getSize());
             }
 
             /**
@@ -80,99 +166,725 @@ namespace foleys
              */
             int getSize () const
             {
-                return static_cast<int> (minBuffer.size());
-            }
-
-            void setSamplesPerBlock (const int numSamples)
-            {
-                samplesPerBlock = numSamples;
+                return levels.empty() ? 0 : static_cast<int> (levels.front().numEntries);
             }
 
             /**
-             @param numBlocks is the number of values the buffer will store. Allow a little safety buffer, so you
-             don't write into the part, where it is currently read
+             Clears the stored values, e.g. after processing was paused
              */
-            void setSize (const int numBlocks)
+            void clear ()
             {
-                minBuffer.resize (size_t (numBlocks), 0.0f);
-                maxBuffer.resize (size_t (numBlocks), 0.0f);
-                writePointer = writePointer % size_t (numBlocks);
+                for (auto& level : levels)
+                {
+                    for (size_t slot = 0; slot < size_t (level.numEntries); ++slot)
+                        storeEntry (level, slot, 0.0f, 0.0f);
+
+                    for (auto& value : level.squares)
+                        value.store (0.0f, std::memory_order_relaxed);
+                }
+
+                numWritten.store (0, std::memory_order_release);
+                fraction = 0;
             }
 
-            void pushChannelData (const float* input, const int numSamples)
+            /**
+             Adds the samples of one channel. The stride is the distance between two samples, e.g. the
+             number of channels of interleaved frames.
+
+             Short blocks, e.g. a few samples at 384 kHz, are reduced in batches: one loop finds min,
+             max and the squares of up to 128 blocks into small arrays on the stack, and then they are
+             merged into the pyramid. Only blocks split between two calls are scanned on their own, so
+             the overhead per call doesn't grow, when the blocks get shorter. Longer blocks are
+             scanned one at a time with the vectorised findMinAndMax.
+             */
+            template<typename SampleType>
+            void pushChannelData (const SampleType* input, const int numSamples, const int stride = 1)
             {
-                // create peak values
                 int samples = 0;
-                juce::Range<float> minMax;
                 while (samples < numSamples)
                 {
-                    auto leftover = numSamples - samples;
-                    if (fraction > 0)
+                    const auto* start = input + juce::int64 (samples) * stride;
+
+                    if (fraction == 0 && samplesPerBlock <= maxShortBlock && numSamples - samples >= samplesPerBlock)
                     {
-                        minMax = juce::FloatVectorOperations::findMinAndMax (input, samplesPerBlock - fraction);
-                        maxBuffer [(size_t) writePointer] = std::max (maxBuffer [(size_t) writePointer], minMax.getEnd());
-                        minBuffer [(size_t) writePointer] = std::min (minBuffer [(size_t) writePointer], minMax.getStart());
-                        samples += samplesPerBlock - fraction;
+                        const auto numBlocks = std::min ((numSamples - samples) / samplesPerBlock, maxBatch);
+
+                        Batch batch;
+                        if (storeRMS)
+                            reduceShortBlocks<true> (start, numBlocks, stride, batch);
+                        else
+                            reduceShortBlocks<false> (start, numBlocks, stride, batch);
+
+                        for (int i = 0; i < numBlocks; ++i)
+                            pushBlockValues (batch.minValues [i], batch.maxValues [i], batch.squares [i] / float (samplesPerBlock));
+
+                        samples += numBlocks * samplesPerBlock;
+                        continue;
+                    }
+
+                    const auto numToRead = std::min (numSamples - samples, samplesPerBlock - fraction);
+                    float squares        = 0.0f;
+                    const auto minMax    = findMinAndMax (start, numToRead, stride, storeRMS ? &squares : nullptr);
+                    jassert (minMax.getStart() == minMax.getStart() && minMax.getEnd() == minMax.getEnd());
+
+                    currentMin     = fraction > 0 ? std::min (currentMin, minMax.getStart()) : minMax.getStart();
+                    currentMax     = fraction > 0 ? std::max (currentMax, minMax.getEnd())   : minMax.getEnd();
+                    currentSquares = fraction > 0 ? currentSquares + squares : squares;
+                    fraction      += numToRead;
+                    samples       += numToRead;
+
+                    if (fraction == samplesPerBlock)
+                    {
+                        pushBlockValues (currentMin, currentMax, currentSquares / float (samplesPerBlock));
                         fraction = 0;
-                        writePointer = (writePointer + 1) % maxBuffer.size();
                     }
-                    else if (leftover > samplesPerBlock)
+                }
+            }
+
+            /** The number of finished blocks since the last clear */
+            juce::int64 getNumWritten() const
+            {
+                return numWritten.load (std::memory_order_acquire);
+            }
+
+            /** Reads a single block from the level 0, it must be inside the stored window */
+            juce::Range<float> getBlock (const juce::int64 index) const
+            {
+                const auto& level = levels.front();
+                const auto  slot  = size_t (index % level.numEntries);
+                if (format == Float32)
+                    return { level.minBuffer [slot].load (std::memory_order_relaxed), level.maxBuffer [slot].load (std::memory_order_relaxed) };
+
+                return decode (readFixed (level, slot));
+            }
+
+            /**
+             Returns min and max of numBlocks blocks, ending blocksAgo blocks before the newest one.
+             Blocks older than the stored window are read with older (first, end).
+             */
+            template<typename OlderBlocks>
+            juce::Range<float> getRecentRange (const int blocksAgo, const int numBlocks, OlderBlocks&& older) const
+            {
+                const auto written = numWritten.load (std::memory_order_acquire);
+                const auto end     = written - blocksAgo;
+                if (format == Float32)
+                    return getRange (end - numBlocks, end, written, readFloat(), older);
+
+                return decode (getRange (end - numBlocks, end, written, readFixedEntry(), encodeOlder (older)));
+            }
+
+            /**
+             Returns the RMS of numBlocks blocks, ending blocksAgo blocks before the newest one. Blocks
+             outside the stored window count as silence, the OutlineHistory doesn't keep the RMS.
+             */
+            float getRecentRMS (const int blocksAgo, const int numBlocks) const
+            {
+                if (! storeRMS || numBlocks < 1)
+                    return 0.0f;
+
+                const auto written = numWritten.load (std::memory_order_acquire);
+                const auto end     = written - blocksAgo;
+                float squares      = 0.0f;
+
+                // for the RMS alone, min and max are not read
+                getRange (end - numBlocks, end, written,
+                          [] (const Level&, const size_t) { return juce::Range<float>(); },
+                          [] (const juce::int64, const juce::int64) { return juce::Range<float>(); },
+                          &squares);
+                return std::sqrt (squares / float (numBlocks));
+            }
+
+            /**
+             Fills one min and max pair per column for numBlocks blocks, ending blocksAgo blocks before
+             the newest one. All columns are read against the same newest block, so they don't tear,
+             if the audio thread pushes meanwhile. Blocks older than the stored window are read with
+             older (first, end). The quantised formats are compared as integers and converted to float
+             for all columns at once.
+             */
+            template<typename OlderBlocks>
+            void getColumns (Columns& columns, const int numColumns, const int numBlocksToRead, const int blocksAgo, OlderBlocks&& older) const
+            {
+                getColumnsEndingAt (columns, numColumns, numBlocksToRead, numWritten.load (std::memory_order_acquire) - blocksAgo, older);
+            }
+
+            /**
+             Same as getColumns, but the last column ends before the block endBlock, counted since the
+             last clear. A caller, that took the number of written blocks earlier, reads exactly these
+             blocks, even if more blocks arrived meanwhile.
+             */
+            template<typename OlderBlocks>
+            void getColumnsEndingAt (Columns& columns, const int numColumns, const int numBlocksToRead, const juce::int64 endBlock, OlderBlocks&& older) const
+            {
+                columns.setSize (numColumns);
+                if (numColumns < 1)
+                    return;
+
+                const auto written   = numWritten.load (std::memory_order_acquire);
+                const auto numBlocks = juce::int64 (std::max (0, numBlocksToRead));
+                const auto start     = endBlock - numBlocks;
+
+                // the mean squares are summed in the same walk through the pyramid as min and max
+                auto readColumn = [&] (const int i, auto&& readEntry, auto&& olderBlocks)
+                {
+                    const auto first   = start + numBlocks * i / numColumns;
+                    const auto end     = start + numBlocks * (i + 1) / numColumns;
+                    float      squares = 0.0f;
+                    const auto range   = getRange (first, end, written, readEntry, olderBlocks, storeRMS ? &squares : nullptr);
+                    columns.rmsValues [size_t (i)] = end > first ? std::sqrt (squares / float (end - first)) : 0.0f;
+                    return range;
+                };
+
+                if (format == Float32)
+                {
+                    for (int i = 0; i < numColumns; ++i)
                     {
-                        minMax = juce::FloatVectorOperations::findMinAndMax (input + samples, samplesPerBlock);
-                        maxBuffer [(size_t) writePointer] = minMax.getEnd();
-                        minBuffer [(size_t) writePointer] = minMax.getStart();
-                        samples += samplesPerBlock;
-                        writePointer = (writePointer + 1) % maxBuffer.size();
+                        const auto range = readColumn (i, readFloat(), older);
+                        columns.minValues [size_t (i)] = range.getStart();
+                        columns.maxValues [size_t (i)] = range.getEnd();
                     }
-                    else
+                    return;
+                }
+
+                columns.fixedMin.resize (size_t (numColumns));
+                columns.fixedMax.resize (size_t (numColumns));
+                for (int i = 0; i < numColumns; ++i)
+                {
+                    const auto range = readColumn (i, readFixedEntry(), encodeOlder (older));
+                    columns.fixedMin [size_t (i)] = range.getStart();
+                    columns.fixedMax [size_t (i)] = range.getEnd();
+                }
+
+                juce::FloatVectorOperations::convertFixedToFloat (columns.minValues.data(), columns.fixedMin.data(), 1.0f / getScale(), numColumns);
+                juce::FloatVectorOperations::convertFixedToFloat (columns.maxValues.data(), columns.fixedMax.data(), 1.0f / getScale(), numColumns);
+            }
+
+        private:
+            static constexpr int maxShortBlock = 32;
+            static constexpr int maxBatch      = 128;
+
+            /** Min, max and the sum of squares of a batch of short blocks */
+            struct Batch
+            {
+                float minValues [maxBatch];
+                float maxValues [maxBatch];
+                float squares   [maxBatch];
+            };
+
+            /** One loop over numBlocks blocks, instead of one findMinAndMax call per block. The squares are only summed withRMS */
+            template<bool withRMS, typename SampleType>
+            void reduceShortBlocks (const SampleType* input, const int numBlocks, const int stride, Batch& batch) const
+            {
+                for (int b = 0; b < numBlocks; ++b)
+                {
+                    const auto* source   = input + juce::int64 (b) * samplesPerBlock * stride;
+                    auto        minValue = float (source [0]);
+                    auto        maxValue = minValue;
+                    auto        squares  = 0.0f;
+                    for (int i = 0; i < samplesPerBlock; ++i)
                     {
-                        minMax = juce::FloatVectorOperations::findMinAndMax (input + samples, leftover);
-                        maxBuffer [(size_t) writePointer] = minMax.getEnd();
-                        minBuffer [(size_t) writePointer] = minMax.getStart();
-                        samples += samplesPerBlock - fraction;
-                        fraction = leftover;
+                        const auto value = float (source [juce::int64 (i) * stride]);
+                        minValue = std::min (minValue, value);
+                        maxValue = std::max (maxValue, value);
+
+                        if constexpr (withRMS)
+                            squares += value * value;
                     }
-                    jassert (minMax.getStart() == minMax.getStart() && minMax.getEnd() == minMax.getEnd());
+
+                    batch.minValues [b] = minValue;
+                    batch.maxValues [b] = maxValue;
+                    batch.squares   [b] = squares;
                 }
             }
 
-            void getChannelOutline (juce::Path& outline, const juce::Rectangle<float> bounds, const int numSamplesToPlot) const
+            /**
+             Strided samples are deinterleaved in small chunks on the stack, so the min/max scan
+             stays vectorised and nothing is copied to a temporary buffer. If sumOfSquares is set,
+             the squares are added up chunk by chunk as well, while the chunk is still in the cache,
+             so the input is read from memory only once.
+             */
+            template<typename SampleType>
+            static juce::Range<float> findMinAndMax (const SampleType* input, const int numSamples, const int stride, float* sumOfSquares)
             {
-                auto numSamples = size_t (numSamplesToPlot);
-                auto latest = writePointer > 0 ? writePointer - 1 : maxBuffer.size() - 1;
-                auto oldest = (latest >= numSamples) ? latest - numSamples : latest + maxBuffer.size() - numSamples;
+                static_assert (std::is_same<SampleType, float>::value || std::is_same<SampleType, double>::value,
+                               "The OutlineBuffer takes float or double samples");
 
-                const auto dx = bounds.getWidth() / numSamples;
-                const auto dy = bounds.getHeight() * 0.35f;
-                const auto my = bounds.getCentreY();
-                auto  x  = bounds.getX();
-                auto  s  = oldest;
+                if (stride == 1 && sumOfSquares == nullptr)
+                {
+                    const auto range = juce::FloatVectorOperations::findMinAndMax (input, numSamples);
+                    return { float (range.getStart()), float (range.getEnd()) };
+                }
+
+                constexpr int chunkSize = 64;
+                float chunk [chunkSize];
+                float minValue = 0.0f;
+                float maxValue = 0.0f;
 
-                outline.startNewSubPath (x, my);
-                for (size_t i=0; i < numSamples; ++i)
+                for (int start = 0; start < numSamples; start += chunkSize)
                 {
-                    outline.lineTo (x, my + minBuffer [s] * dy);
-                    x += dx;
-                    if (s < minBuffer.size() - 1)
-                        s += 1;
-                    else
-                        s = 0;
+                    const auto   numInChunk = std::min (chunkSize, numSamples - start);
+                    const auto*  source     = input + juce::int64 (start) * stride;
+                    const float* values     = chunk;
+
+                    if constexpr (std::is_same<SampleType, float>::value)
+                    {
+                        if (stride == 1)
+                            values = source;
+                    }
+
+                    if (values == chunk)
+                        for (int i = 0; i < numInChunk; ++i)
+                            chunk [i] = float (source [juce::int64 (i) * stride]);
+
+                    const auto range = juce::FloatVectorOperations::findMinAndMax (values, numInChunk);
+                    minValue = start > 0 ? std::min (minValue, range.getStart()) : range.getStart();
+                    maxValue = start > 0 ? std::max (maxValue, range.getEnd())   : range.getEnd();
+
+                    if (sumOfSquares != nullptr)
+                        *sumOfSquares += getSumOfSquares (values, numInChunk);
+                }
+
+                return { minValue, maxValue };
+            }
+
+            /** Four independent sums, so the compiler can keep them in one vector register */
+            static float getSumOfSquares (const float* values, const int numValues)
+            {
+                float sums [4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                int   i = 0;
+                for (; i + 4 <= numValues; i += 4)
+                    for (int k = 0; k < 4; ++k)
+                        sums [k] += values [i + k] * values [i + k];
+
+                auto sum = (sums [0] + sums [1]) + (sums [2] + sums [3]);
+                for (; i < numValues; ++i)
+                    sum += values [i] * values [i];
+
+                return sum;
+            }
+
+            /**
+             Returns min and max of the blocks from first to end, counted since the last clear. Each
+             block is read from the highest level, that has an entry aligned to it, so a span of any
+             length costs a few reads per level. Blocks, that are not written yet, read as silence.
+             The values are float or the undecoded integers of the quantised formats, as returned by
+             readEntry (level, slot). If sumOfSquares is set, the mean squares of the stored blocks are
+             added to it.
+             */
+            template<typename ReadEntry, typename OlderBlocks>
+            auto getRange (juce::int64 first, const juce::int64 end, const juce::int64 written, ReadEntry&& readEntry, OlderBlocks&& older,
+                           float* sumOfSquares = nullptr) const
+                -> juce::Range<decltype (readEntry (std::declval<const Level&>(), size_t()).getStart())>
+            {
+                using ValueType = decltype (readEntry (levels.front(), size_t()).getStart());
+
+                const auto oldest  = std::max (juce::int64 (0), written - juce::int64 (getSize()));
+                const auto last    = std::min (end, written);
+
+                ValueType minValue = 0;
+                ValueType maxValue = 0;
+                bool      empty    = last >= end;
+                if (first < oldest)
+                {
+                    const auto range = older (first, std::min (oldest, end));
+                    minValue = empty ? range.getStart() : std::min (minValue, range.getStart());
+                    maxValue = empty ? range.getEnd()   : std::max (maxValue, range.getEnd());
+                    empty    = false;
+                    first    = oldest;
+                }
+
+                while (first < last)
+                {
+                    size_t k = 0;
+                    while (k + 1 < levels.size())
+                    {
+                        const auto& next       = levels [k + 1];
+                        const auto  span       = next.blocksPerEntry;
+                        if (first % span != 0 || first + span > last || first / span < written / span - next.numEntries)
+                            break;
+
+                        ++k;
+                    }
+
+                    const auto& level = levels [k];
+                    const auto  slot  = size_t ((first / level.blocksPerEntry) % level.numEntries);
+                    const auto  range = readEntry (level, slot);
+                    if (sumOfSquares != nullptr)
+                        *sumOfSquares += level.squares [slot].load (std::memory_order_relaxed);
+
+                    minValue = empty ? range.getStart() : std::min (minValue, range.getStart());
+                    maxValue = empty ? range.getEnd()   : std::max (maxValue, range.getEnd());
+                    empty    = false;
+                    first   += level.blocksPerEntry;
+                }
+
+                return juce::Range<ValueType> (minValue, maxValue);
+            }
+
+            static auto readFloat()
+            {
+                return [] (const Level& level, const size_t slot)
+                {
+                    return juce::Range<float> (level.minBuffer [slot].load (std::memory_order_relaxed),
+                                               level.maxBuffer [slot].load (std::memory_order_relaxed));
+                };
+            }
+
+            auto readFixedEntry() const
+            {
+                return [this] (const Level& level, const size_t slot) { return readFixed (level, slot); };
+            }
+
+            /** The blocks from the OutlineHistory are float, they are compared in the quantised format */
+            template<typename OlderBlocks>
+            auto encodeOlder (OlderBlocks& older) const
+            {
+                return [this, &older] (const juce::int64 first, const juce::int64 end)
+                {
+                    const auto range = older (first, end);
+                    return juce::Range<int> (toFixed (range.getStart(), false), toFixed (range.getEnd(), true));
+                };
+            }
+
+            juce::Range<int> readFixed (const Level& level, const size_t slot) const
+            {
+                if (format == Int8)
+                {
+                    const auto entry = level.packed8 [slot].load (std::memory_order_relaxed);
+                    return { int (juce::int8 (entry & 0xff)), int (juce::int8 (entry >> 8)) };
+                }
+
+                const auto entry = level.packed16 [slot].load (std::memory_order_relaxed);
+                return { int (juce::int16 (entry & 0xffff)), int (juce::int16 (entry >> 16)) };
+            }
+
+            void storeEntry (Level& level, const size_t slot, const float minValue, const float maxValue)
+            {
+                if (format == Float32)
+                {
+                    level.minBuffer [slot].store (minValue, std::memory_order_relaxed);
+                    level.maxBuffer [slot].store (maxValue, std::memory_order_relaxed);
                 }
+                else if (format == Int8)
+                {
+                    const auto low  = juce::uint16 (juce::uint8 (toFixed (minValue, false)));
+                    const auto high = juce::uint16 (juce::uint8 (toFixed (maxValue, true)));
+                    level.packed8 [slot].store (juce::uint16 (low | (high << 8)), std::memory_order_relaxed);
+                }
+                else
+                {
+                    const auto low  = juce::uint32 (juce::uint16 (toFixed (minValue, false)));
+                    const auto high = juce::uint32 (juce::uint16 (toFixed (maxValue, true)));
+                    level.packed16 [slot].store (low | (high << 16), std::memory_order_relaxed);
+                }
+            }
+
+            /** The min is rounded down and the max up, so the outline never gets smaller */
+            int toFixed (const float value, const bool roundUp) const
+            {
+                const auto limit  = format == Int8 ? 127 : 32767;
+                const auto scaled = value * getScale();
+                return juce::jlimit (-limit - 1, limit, int (roundUp ? std::ceil (scaled) : std::floor (scaled)));
+            }
+
+            juce::Range<float> decode (const juce::Range<int> range) const
+            {
+                return { float (range.getStart()) / getScale(), float (range.getEnd()) / getScale() };
+            }
 
-                for (size_t i=0; i < numSamples; ++i)
+            float getScale() const
+            {
+                return format == Int8 ? 127.0f / 2.0f : 32767.0f / 4.0f;
+            }
+
+            void allocate (const int numBlocks)
+            {
+                const auto size = juce::int64 (std::max (1, numBlocks));
+                for (juce::int64 blocksPerEntry = 1; levels.empty() || blocksPerEntry < size; blocksPerEntry *= factor)
                 {
-                    outline.lineTo (x, my + maxBuffer [s] * dy);
-                    x -= dx;
-                    if (s > 1)
-                        s -= 1;
+                    // one spare entry, so the top levels cover at least the history of the level 0
+                    const auto numEntries = levels.empty() ? size : (size + blocksPerEntry - 1) / blocksPerEntry + 1;
+
+                    Level level;
+                    level.blocksPerEntry = blocksPerEntry;
+                    level.numEntries     = numEntries;
+                    if (format == Float32)
+                    {
+                        level.minBuffer = std::vector<std::atomic<float>> (size_t (numEntries));
+                        level.maxBuffer = std::vector<std::atomic<float>> (size_t (numEntries));
+                    }
+                    else if (format == Int8)
+                    {
+                        level.packed8 = std::vector<std::atomic<juce::uint16>> (size_t (numEntries));
+                    }
                     else
-                        s = maxBuffer.size() - 1;
+                    {
+                        level.packed16 = std::vector<std::atomic<juce::uint32>> (size_t (numEntries));
+                    }
+
+                    if (storeRMS)
+                        level.squares = std::vector<std::atomic<float>> (size_t (numEntries));
+
+                    levels.push_back (std::move (level));
                 }
             }
+
+            /**
+             Stores a finished block in the level 0 and merges it into the levels above. A level is
+             only touched, when an entry of the level below is complete, so a block costs about two
+             merges, regardless of the number of levels. The block is published with numWritten only
+             after all levels are written, so readers never see a partially merged block.
+             */
+            void pushBlockValues (float minValue, float maxValue, float squares)
+            {
+                const auto index            = numWritten.load (std::memory_order_relaxed);
+                juce::int64 blocksPerMerged = 1;
+
+                for (auto& level : levels)
+                {
+                    const auto position = index % level.blocksPerEntry;
+                    const auto first    = position < blocksPerMerged;
+                    level.pendingMin     = first ? minValue : std::min (level.pendingMin, minValue);
+                    level.pendingMax     = first ? maxValue : std::max (level.pendingMax, maxValue);
+                    level.pendingSquares = first ? squares  : level.pendingSquares + squares;
+
+                    if (position != level.blocksPerEntry - 1)
+                        break;
+
+                    const auto slot = size_t ((index / level.blocksPerEntry) % level.numEntries);
+                    storeEntry (level, slot, level.pendingMin, level.pendingMax);
+                    if (storeRMS)
+                        level.squares [slot].store (level.pendingSquares, std::memory_order_relaxed);
+
+                    // the completed entry is merged into the level above
+                    minValue        = level.pendingMin;
+                    maxValue        = level.pendingMax;
+                    squares         = level.pendingSquares;
+                    blocksPerMerged = level.blocksPerEntry;
+                }
+
+                numWritten.store (index + 1, std::memory_order_release);
+            }
         };
 
-        std::vector<ChannelData> channelDatas;
-        int                      samplesPerBlock = 128;
+        /** All channels of one size. A resize builds a new one next to the one in use */
+        struct Storage
+        {
+            Storage (const int numChannels, const int numBlocks, const int pyramidFactor, const int samplesPerBlock, const StorageFormat format,
+                     const bool storeRMS, const juce::uint32 generationToUse)
+              : generation (generationToUse)
+            {
+                channels.reserve (size_t (std::max (0, numChannels)));
+                for (int i = 0; i < numChannels; ++i)
+                    channels.emplace_back (numBlocks, pyramidFactor, samplesPerBlock, format, storeRMS);
+            }
+
+            std::vector<ChannelData>  channels;
+            const juce::uint32        generation;
+            std::atomic<juce::uint32> numClears { 0 };
+        };
+
+        /**
+         Pins the active storage for the audio thread or a reader. It never waits: if a resize
+         switched the storage in between, it pins the new one instead.
+         */
+        class ScopedStorage
+        {
+        public:
+            explicit ScopedStorage (const OutlineBuffer& ownerToUse)
+              : owner (ownerToUse)
+            {
+                for (;;)
+                {
+                    index = owner.active.load();
+                    ++owner.numUsers [index];
+                    if (owner.active.load() == index)
+                        break;
+
+                    --owner.numUsers [index];
+                }
+            }
+
+            ~ScopedStorage()
+            {
+                --owner.numUsers [index];
+            }
+
+            Storage& operator*() const  { return *owner.storages [size_t (index)]; }
+            Storage* operator->() const { return owner.storages [size_t (index)].get(); }
+
+        private:
+            const OutlineBuffer& owner;
+            int                  index = 0;
+
+            JUCE_DECLARE_NON_COPYABLE (ScopedStorage)
+        };
+
+        /**
+         Builds the new storage in the slot, that is not active, and switches over. The old storage
+         is freed, once the audio thread and the readers left it. Only the resize waits, the audio
+         thread and the readers don't.
+         */
+        void rebuild()
+        {
+            std::lock_guard<std::mutex> lock (resizeLock);
+
+            const auto next = 1 - active.load();
+            waitUntilUnused (next);
+            storages [size_t (next)] = std::make_unique<Storage> (requestedChannels, requestedBlocks, requestedPyramidFactor, requestedSamplesPerBlock,
+                                                                 requestedFormat, requestedRMS, ++generation);
+
+            active.store (next);
+
+            waitUntilUnused (1 - next);
+            storages [size_t (1 - next)].reset();
+        }
+
+        void waitUntilUnused (const int index) const
+        {
+            while (numUsers [index].load() > 0)
+                juce::Thread::yield();
+        }
+
+        /** Pushes all channels. getChannel returns the first sample of a channel */
+        template<typename GetChannel>
+        void pushChannels (const int numChannelsIn, const int numSamples, const int stride, GetChannel&& getChannel)
+        {
+            if (! consumers.shouldProcess (numSamples))
+                return;
+
+            ScopedStorage storage (*this);
+            auto& channelDatas = storage->channels;
+
+            if (consumers.checkResumed())
+            {
+                for (auto& data : channelDatas)
+                    data.clear();
+
+                storage->numClears.fetch_add (1, std::memory_order_release);
+            }
+
+            const auto numChannels = std::min (numChannelsIn, int (channelDatas.size()));
+            auto pushRange = [&] (const int begin, const int end)
+            {
+                for (int i = begin; i < end; ++i)
+                    channelDatas [size_t (i)].pushChannelData (getChannel (i), numSamples, stride);
+            };
+
+            if (auto* pool = workerPool.load (std::memory_order_acquire))
+                pool->forEachChannelRange (numChannels, numSamples, pushRange);
+            else
+                pushRange (0, numChannels);
+        }
+
+        /**
+         Copies the finished blocks of all channels to the OutlineHistory. This runs on its own
+         thread, so the audio thread never touches the file.
+         */
+        class HistoryWriter : public juce::Thread
+        {
+        public:
+            HistoryWriter (OutlineBuffer& ownerToUse, OutlineHistory& historyToUse)
+              : juce::Thread ("Outline history"),
+                owner (ownerToUse),
+                history (historyToUse),
+                cursors (size_t (historyToUse.getNumChannels()))
+            {
+            }
+
+            void run() override
+            {
+                while (! threadShouldExit())
+                {
+                    copyBlocks();
+                    wait (interval);
+                }
+
+                copyBlocks();
+            }
+
+        private:
+            /** Remembers, how far a channel was copied, and from which storage */
+            struct Cursor
+            {
+                juce::uint32 generation = 0;
+                juce::uint32 numClears  = 0;
+                juce::int64  copied     = 0;
+            };
+
+            void copyBlocks()
+            {
+                ScopedStorage storage (owner);
+                const auto numClears = storage->numClears.load (std::memory_order_acquire);
+                const auto numChannels = std::min (cursors.size(), storage->channels.size());
+
+                for (size_t c = 0; c < numChannels; ++c)
+                {
+                    auto&       cursor  = cursors [c];
+                    auto&       data    = storage->channels [c];
+                    const auto  written = data.getNumWritten();
+
+                    // after a resize or a clear the blocks are counted from zero again
+                    if (cursor.generation != storage->generation || cursor.numClears != numClears || written < cursor.copied)
+                        cursor = { storage->generation, numClears, 0 };
+
+                    // blocks, that were overwritten before they were copied, are lost. They are kept
+                    // as silence, so the history stays aligned with the blocks of the buffer
+                    const auto firstAvailable = written - juce::int64 (data.getSize());
+                    for (; cursor.copied < firstAvailable; ++cursor.copied)
+                        history.append (int (c), 0.0f, 0.0f);
+
+                    for (; cursor.copied < written; ++cursor.copied)
+                    {
+                        const auto block = data.getBlock (cursor.copied);
+                        history.append (int (c), block.getStart(), block.getEnd());
+                    }
+
+                    data.setHistoryOffset (history.getNumBlocks (int (c)) - written);
+                }
+            }
+
+            static constexpr int interval = 20;
+
+            OutlineBuffer&      owner;
+            OutlineHistory&     history;
+            std::vector<Cursor> cursors;
+
+            JUCE_DECLARE_NON_COPYABLE (HistoryWriter)
+        };
+
+        /** Reads the blocks older than the window in RAM from the history, if there is one */
+        juce::Range<float> readHistory (const ChannelData& data, const int channel, const juce::int64 first, const juce::int64 end) const
+        {
+            const auto* history = historyFile.load (std::memory_order_acquire);
+            if (history == nullptr)
+                return {};
+
+            const auto offset = data.getHistoryOffset();
+            return history->getRange (channel, first + offset, end + offset);
+        }
+
+        std::array<std::unique_ptr<Storage>, 2> storages { { std::make_unique<Storage> (0, 1, 2, 128, Float32, false, 0), nullptr } };
+        std::atomic<int>                        active   { 0 };
+        mutable std::array<std::atomic<int>, 2> numUsers { { { 0 }, { 0 } } };
+        std::mutex                              resizeLock;
+        juce::uint32                            generation = 0;
+
+        std::atomic<OutlineHistory*>            historyFile { nullptr };
+        std::unique_ptr<HistoryWriter>          historyWriter;
+
+        // only used on the thread calling the setters
+        int                           requestedChannels        = 0;
+        int                           requestedBlocks          = 1024;
+        int                           requestedSamplesPerBlock = 128;
+        int                           requestedPyramidFactor   = 2;
+        StorageFormat                 requestedFormat          = Float32;
+        bool                          requestedRMS             = false;
+
+        MeterConsumers                consumers;
+        std::atomic<MeterWorkerPool*> workerPool { nullptr };
+
+        // the history records, even if no component is showing the outline
+        MeterConsumers::Registration  historyRegistration;
 
 
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OutlineBuffer)
@@ -181,40 +893,169 @@ namespace foleys
         {
         }
 
+        ~OutlineBuffer ()
+        {
+            setHistory (nullptr);
+        }
+
+        /**
+         Keeps the blocks, that fall out of the window in RAM, in an OutlineHistory on disk. A
+         background thread copies them, the outline and range queries read the older blocks from
+         the file, so you can scroll back over hours. The history must stay open, until it is
+         removed again with nullptr.
+         While a history is attached, the buffer counts as watched and is not suspended, so the
+         recording has no gaps, when the editor is closed.
+         */
+        void setHistory (OutlineHistory* history)
+        {
+            if (historyWriter != nullptr)
+                historyWriter->stopThread (1000);
+
+            historyWriter.reset();
+            historyFile.store (history, std::memory_order_release);
+
+            if (history != nullptr && history->isOpen())
+            {
+                historyWriter = std::make_unique<HistoryWriter> (*this, *history);
+                historyWriter->startThread();
+            }
+
+            historyRegistration.setConsumers (&consumers);
+            historyRegistration.setInterested (historyWriter != nullptr);
+        }
+
         /**
          @param numChannels is the number of channels the buffer will store
          @param numBlocks is the number of values the buffer will store. Allow a little safety buffer, so you
          don't write into the part, where it is currently read
+         The buffer is swapped while the audio thread and the readers continue, so it can be called
+         from any thread, except the audio thread. This clears the buffer.
          */
         void setSize (const int numChannels, const int numBlocks)
         {
-            channelDatas.resize (size_t (numChannels));
-            for (auto& data : channelDatas) {
-                data.setSize (numBlocks);
-                data.setSamplesPerBlock (samplesPerBlock);
-            }
+            requestedChannels = std::max (0, numChannels);
+            requestedBlocks   = std::max (1, numBlocks);
+            rebuild();
+        }
+
+        /**
+         The outline keeps a pyramid of min and max values, each level decimating the one below
+         by this factor. Zoomed out outlines are read from the higher levels, so their cost depends
+         on the width in pixels and not on the length of the history. The default is 2. This clears
+         the buffer.
+         */
+        void setPyramidFactor (const int factor)
+        {
+            requestedPyramidFactor = std::max (2, factor);
+            rebuild();
+        }
+
+        /**
+         Stores min and max quantised to 16 or 8 bit instead of float, see StorageFormat. This
+         clears the buffer.
+         */
+        void setStorageFormat (const StorageFormat format)
+        {
+            requestedFormat = format;
+            rebuild();
+        }
+
+        /**
+         Stores the RMS of each block next to min and max. The squares are summed in the same pass
+         over the samples as min and max, and getChannelColumns returns the RMS of each column
+         together with min and max. The RMS is always stored as float and is not copied to the
+         OutlineHistory. This clears the buffer.
+         */
+        void setRMSEnabled (const bool shouldStoreRMS)
+        {
+            requestedRMS = shouldStoreRMS;
+            rebuild();
         }
 
         /**
-         @param numSamples sets the size of each analysed block
+         @param numSamples sets the size of each analysed block. This clears the buffer.
          */
         void setSamplesPerBlock (const int numSamples)
         {
-            samplesPerBlock = numSamples;
-            for (auto& data : channelDatas)
-                data.setSamplesPerBlock (numSamples);
+            requestedSamplesPerBlock = std::max (1, numSamples);
+            rebuild();
         }
 
         /**
          Push a block of audio samples into the outline buffer.
          */
-        void pushBlock (const juce::AudioBuffer<float>& buffer, const int numSamples)
+        template<typename SampleType>
+        void pushBlock (const juce::AudioBuffer<SampleType>& buffer, const int numSamples)
         {
-            for (int i=0; i < buffer.getNumChannels(); ++i) {
-                if (i < int (channelDatas.size())) {
-                    channelDatas [size_t (i)].pushChannelData (buffer.getReadPointer (i), numSamples);
-                }
-            }
+            pushBlock (buffer.getArrayOfReadPointers(), buffer.getNumChannels(), numSamples);
+        }
+
+        /**
+         Push a block of samples from an array of channel pointers, e.g. from a host or a driver callback.
+         */
+        template<typename SampleType>
+        void pushBlock (const SampleType* const* channels, const int numChannels, const int numSamples)
+        {
+            pushChannels (numChannels, numSamples, 1, [channels] (const int channel) { return channels [channel]; });
+        }
+
+        /**
+         Push interleaved frames, e.g. from a capture device, without deinterleaving them first.
+         @param frames points to numSamples frames of numChannels samples each
+         */
+        template<typename SampleType>
+        void pushInterleavedBlock (const SampleType* frames, const int numChannels, const int numSamples)
+        {
+            pushChannels (numChannels, numSamples, numChannels, [frames] (const int channel) { return frames + channel; });
+        }
+
+        /**
+         Splits the channels of wide buffers across the workers of the pool, see
+         MeterWorkerPool. Set nullptr to push the channels serially.
+         */
+        void setWorkerPool (MeterWorkerPool* pool)
+        {
+            workerPool.store (pool, std::memory_order_release);
+        }
+
+        /**
+         Register a MeterConsumers::Registration here from the component, that draws the outline.
+         While no consumer is interested, the pushed blocks are skipped.
+         */
+        MeterConsumers& getConsumers ()
+        {
+            return consumers;
+        }
+
+        /** Returns the number of channels of the storage in use */
+        int getNumChannels() const
+        {
+            ScopedStorage storage (*this);
+            return static_cast<int> (storage->channels.size());
+        }
+
+        /**
+         Returns the number of blocks of a channel since the last clear. Compare it to the count
+         of the last repaint to find out, how many blocks arrived in between. If getClearCount
+         changed meanwhile, the buffer was cleared or resized and the count started from zero.
+         */
+        juce::int64 getNumBlocksWritten (const int channel) const
+        {
+            ScopedStorage storage (*this);
+            if (juce::isPositiveAndBelow (channel, int (storage->channels.size())))
+                return storage->channels [size_t (channel)].getNumWritten();
+
+            return 0;
+        }
+
+        /**
+         Returns a number, that changes each time the buffer is cleared or resized. Read it before
+         getNumBlocksWritten, a count that only got bigger may still belong to a new clear.
+         */
+        juce::uint64 getClearCount() const
+        {
+            ScopedStorage storage (*this);
+            return (juce::uint64 (storage->generation) << 32) | storage->numClears.load (std::memory_order_acquire);
         }
 
         /**
@@ -227,8 +1068,170 @@ namespace foleys
          */
         void getChannelOutline (juce::Path& path, const juce::Rectangle<float> bounds, const int channel, const int numSamples) const
         {
-            if (channel < int (channelDatas.size()))
-                return channelDatas [size_t (channel)].getChannelOutline (path, bounds, numSamples);
+            Columns columns;
+            getChannelOutline (path, bounds, channel, numSamples, columns);
+        }
+
+        /**
+         Same as above, but doesn't allocate, if you keep the path and the columns between repaints.
+         Clear the path before, it keeps its storage. There is one point per pixel column, or one per
+         block, if there are less blocks than pixels.
+         */
+        void getChannelOutline (juce::Path& path, const juce::Rectangle<float> bounds, const int channel, const int numSamples,
+                                Columns& columns) const
+        {
+            const auto numColumns = std::min (numSamples, std::max (1, int (std::ceil (bounds.getWidth()))));
+            getChannelColumns (columns, channel, numColumns, numSamples);
+            addOutline (path, bounds, columns);
+        }
+
+        /**
+         Fills min and max for each pixel column, e.g. to draw the outline with your own primitives.
+         Each column is read from the pyramid, so the cost depends on the number of columns and not
+         on the number of blocks.
+         @param columns receives the values, it only allocates, if it needs more columns than before
+         @param channel the index of the channel
+         @param numColumns the number of columns, usually the width in pixels
+         @param numBlocks the number of blocks to spread over the columns
+         @param blocksAgo the number of blocks between the last column and the newest block
+         */
+        void getChannelColumns (Columns& columns, const int channel, const int numColumns, const int numBlocks, const int blocksAgo = 0) const
+        {
+            ScopedStorage storage (*this);
+            if (juce::isPositiveAndBelow (channel, int (storage->channels.size())))
+            {
+                const auto& data = storage->channels [size_t (channel)];
+                data.getColumns (columns, numColumns, numBlocks, blocksAgo, [&] (const juce::int64 first, const juce::int64 end)
+                {
+                    return readHistory (data, channel, first, end);
+                });
+            }
+            else
+                columns.setSize (0);
+        }
+
+        /**
+         Same as getChannelColumns, but the last column ends before the block endBlock, counted since
+         the last clear as returned by getNumBlocksWritten. Take the number of written blocks once and
+         pass it for all channels, so the columns are read from the same blocks, while the audio
+         thread keeps pushing.
+         */
+        void getChannelColumnsEndingAt (Columns& columns, const int channel, const int numColumns, const int numBlocks, const juce::int64 endBlock) const
+        {
+            ScopedStorage storage (*this);
+            if (juce::isPositiveAndBelow (channel, int (storage->channels.size())))
+            {
+                const auto& data = storage->channels [size_t (channel)];
+                data.getColumnsEndingAt (columns, numColumns, numBlocks, endBlock, [&] (const juce::int64 first, const juce::int64 end)
+                {
+                    return readHistory (data, channel, first, end);
+                });
+            }
+            else
+                columns.setSize (0);
+        }
+
+        /**
+         Adds the outline of the columns to the path: the minima from left to right and the maxima back.
+         The space for the points is reserved up front.
+         */
+        static void addOutline (juce::Path& path, const juce::Rectangle<float> bounds, const Columns& columns)
+        {
+            const auto numColumns = columns.size();
+            if (numColumns < 1)
+                return;
+
+            const auto dx = numColumns > 1 ? bounds.getWidth() / float (numColumns - 1) : 0.0f;
+            const auto dy = bounds.getHeight() * 0.35f;
+            const auto my = bounds.getCentreY();
+
+            // each point takes a type marker and two coordinates
+            path.preallocateSpace (6 * numColumns + 1);
+
+            path.startNewSubPath (bounds.getX(), my + columns.minValues.front() * dy);
+            for (int i = 1; i < numColumns; ++i)
+                path.lineTo (bounds.getX() + float (i) * dx, my + columns.minValues [size_t (i)] * dy);
+
+            for (int i = numColumns - 1; i >= 0; --i)
+                path.lineTo (bounds.getX() + float (i) * dx, my + columns.maxValues [size_t (i)] * dy);
+
+            path.closeSubPath();
+        }
+
+        /**
+         Returns min and max of a span of the history of a channel, e.g. for a zoomed or scrolled view.
+         @param channel the index of the channel
+         @param blocksAgo the number of blocks between the end of the span and the newest block
+         @param numBlocks the length of the span in blocks
+         */
+        juce::Range<float> getChannelRange (const int channel, const int blocksAgo, const int numBlocks) const
+        {
+            ScopedStorage storage (*this);
+            if (juce::isPositiveAndBelow (channel, int (storage->channels.size())))
+            {
+                const auto& data = storage->channels [size_t (channel)];
+                return data.getRecentRange (blocksAgo, numBlocks, [&] (const juce::int64 first, const juce::int64 end)
+                {
+                    return readHistory (data, channel, first, end);
+                });
+            }
+
+            return {};
+        }
+
+        /**
+         Returns the RMS of a span of the history of a channel, or 0, if the RMS is not enabled.
+         @param channel the index of the channel
+         @param blocksAgo the number of blocks between the end of the span and the newest block
+         @param numBlocks the length of the span in blocks
+         */
+        float getChannelRMS (const int channel, const int blocksAgo, const int numBlocks) const
+        {
+            ScopedStorage storage (*this);
+            if (juce::isPositiveAndBelow (channel, int (storage->channels.size())))
+                return storage->channels [size_t (channel)].getRecentRMS (blocksAgo, numBlocks);
+
+            return 0.0f;
+        }
+
+        /**
+         Returns the RMS envelope of a specific channel inside the bounds, to draw on top of the
+         outline. Like getChannelOutline, but from the rmsValues of the columns. To draw both
+         layers from one read, call getChannelColumns once and pass the columns to addOutline and
+         addRMSOutline.
+         */
+        void getChannelRMSOutline (juce::Path& path, const juce::Rectangle<float> bounds, const int channel, const int numSamples,
+                                   Columns& columns) const
+        {
+            const auto numColumns = std::min (numSamples, std::max (1, int (std::ceil (bounds.getWidth()))));
+            getChannelColumns (columns, channel, numColumns, numSamples);
+            addRMSOutline (path, bounds, columns);
+        }
+
+        /**
+         Adds the RMS envelope of the columns to the path, from -rms to +rms around the centre, in
+         the same scale as addOutline.
+         */
+        static void addRMSOutline (juce::Path& path, const juce::Rectangle<float> bounds, const Columns& columns)
+        {
+            const auto numColumns = static_cast<int> (columns.rmsValues.size());
+            if (numColumns < 1)
+                return;
+
+            const auto dx = numColumns > 1 ? bounds.getWidth() / float (numColumns - 1) : 0.0f;
+            const auto dy = bounds.getHeight() * 0.35f;
+            const auto my = bounds.getCentreY();
+
+            path.preallocateSpace (6 * numColumns + 1);
+
+            path.startNewSubPath (bounds.getX(), my - columns.rmsValues.front() * dy);
+            for (int i = 1; i < numColumns; ++i)
+                path.lineTo (bounds.getX() + float (i) * dx, my - columns.rmsValues [size_t (i)] * dy);
+
+            for (int i = numColumns - 1; i >= 0; --i)
+                path.lineTo (bounds.getX() + float (i) * dx, my + columns.rmsValues [size_t (i)] * dy);
+
+            path.closeSubPath();
         }
 
         /**
@@ -239,13 +1242,22 @@ namespace foleys
          @return a path with a single channel outline (min to max)
          */
         void getChannelOutline (juce::Path& path, const juce::Rectangle<float> bounds, const int numSamples) const
+        {
+            Columns columns;
+            getChannelOutline (path, bounds, numSamples, columns);
+        }
+
+        /**
+         Same as above, but doesn't allocate, if you keep the path and the columns between repaints.
+         */
+        void getChannelOutline (juce::Path& path, const juce::Rectangle<float> bounds, const int numSamples, Columns& columns) const
         {
             juce::Rectangle<float>  b (bounds);
-            const int   numChannels = static_cast<int> (channelDatas.size());
+            const int   numChannels = getNumChannels();
             const float h           = bounds.getHeight() / numChannels;
 
             for (int i=0; i < numChannels; ++i) {
-                getChannelOutline (path, b.removeFromTop (h) , i, numSamples);
+                getChannelOutline (path, b.removeFromTop (h) , i, numSamples, columns);
             }
         }
 
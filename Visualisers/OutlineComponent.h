@@ -0,0 +1,265 @@
+/*
+ ==============================================================================
+ Copyright (c) 2017 - 2020 Foleys Finest Audio Ltd. - Daniel Walz
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+ 1. Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+ 3. Neither the name of the copyright holder nor the names of its contributors
+    may be used to endorse or promote products derived from this software without
+    specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ==============================================================================
+
+    OutlineComponent.h
+    Author:  Daniel Walz
+
+ ==============================================================================
+*/
+
+#pragma once
+
+namespace foleys
+{
+
+    /** @addtogroup ff_meters */
+    /*@{*/
+
+    /**
+     \class OutlineComponent
+
+     Shows the OutlineBuffer as a waveform scrolling from right to left, one row per channel.
+     The waveform is kept in an image. On each refresh the image is moved left by the number of
+     new pixel columns, and only those are read from the OutlineBuffer and drawn, so the cost
+     per frame depends on the new blocks and not on the width.
+
+     It uses the colours of the LevelMeter: lmBackgroundColour, lmMeterGradientLowColour for the
+     waveform, lmMeterGradientMaxColour for columns reaching full scale,
+     lmMeterGradientMidColour for the RMS, if it is enabled in the OutlineBuffer, and
+     lmMeterBackgroundColour for the centre lines. If the LookAndFeel doesn't implement
+     LevelMeter::LookAndFeelMethods, the colours of the LevelMeterLookAndFeel are used.
+     */
+    class OutlineComponent : public juce::Component,
+                             private juce::Timer
+    {
+    public:
+        explicit OutlineComponent (OutlineBuffer& outlineToUse)
+          : outline (outlineToUse)
+        {
+            setOpaque (true);
+            registration.setConsumers (&outline.getConsumers());
+            updateColours();
+            startTimerHz (refreshRate);
+        }
+
+        ~OutlineComponent() override
+        {
+            stopTimer();
+        }
+
+        /**
+         Sets, how many blocks of the OutlineBuffer are combined into one pixel column, i.e. the
+         speed of the scrolling. This redraws the whole image.
+         */
+        void setBlocksPerPixel (const int numBlocks)
+        {
+            blocksPerPixel  = std::max (1, numBlocks);
+            needsFullRedraw = true;
+        }
+
+        int getBlocksPerPixel() const
+        {
+            return blocksPerPixel;
+        }
+
+        void setRefreshRateHz (const int newRefreshRate)
+        {
+            refreshRate = std::max (1, newRefreshRate);
+            startTimerHz (refreshRate);
+        }
+
+        void paint (juce::Graphics& g) override
+        {
+            if (image.isValid())
+                g.drawImageAt (image, 0, 0);
+            else
+                g.fillAll (backgroundColour);
+        }
+
+        void resized() override
+        {
+            needsFullRedraw = true;
+            updateImage();
+        }
+
+        void visibilityChanged() override
+        {
+            registration.setInterested (isShowing());
+        }
+
+        void parentHierarchyChanged() override
+        {
+            registration.setInterested (isShowing());
+            updateColours();
+        }
+
+        void lookAndFeelChanged() override
+        {
+            updateColours();
+        }
+
+        void colourChanged() override
+        {
+            updateColours();
+        }
+
+    private:
+        void timerCallback() override
+        {
+            // a parent being hidden doesn't call visibilityChanged, so this is checked here as well
+            registration.setInterested (isShowing());
+            updateImage();
+        }
+
+        /**
+         Moves the image by the columns, that were completed since the last update, and draws
+         them. The columns are aligned to multiples of blocksPerPixel blocks since the last clear,
+         so a column is always drawn from the same blocks.
+         */
+        void updateImage()
+        {
+            const auto width  = getWidth();
+            const auto height = getHeight();
+            if (width < 1 || height < 1)
+                return;
+
+            if (image.getWidth() != width || image.getHeight() != height)
+            {
+                image = juce::Image (juce::Image::RGB, width, height, false);
+                needsFullRedraw = true;
+            }
+
+            const auto numChannels = outline.getNumChannels();
+            const auto clearCount  = outline.getClearCount();
+
+            // a push may be half way through the channels, so take the blocks all channels have
+            auto written = outline.getNumBlocksWritten (0);
+            for (int channel = 1; channel < numChannels; ++channel)
+                written = std::min (written, outline.getNumBlocksWritten (channel));
+
+            const auto numColumns = written / blocksPerPixel;
+
+            // after a clear or resize the blocks are counted from zero, even if they refilled past the last count
+            if (numChannels != lastNumChannels || clearCount != lastClearCount || numColumns < lastNumColumns)
+                needsFullRedraw = true;
+
+            const auto numNew = needsFullRedraw ? width : int (std::min (juce::int64 (width), numColumns - lastNumColumns));
+            if (numNew < 1)
+                return;
+
+            if (numNew < width)
+                image.moveImageSection (0, 0, numNew, 0, width - numNew, height);
+
+            drawColumns (width - numNew, numNew, numColumns * blocksPerPixel, numChannels);
+
+            lastNumColumns  = numColumns;
+            lastNumChannels = numChannels;
+            lastClearCount  = clearCount;
+            needsFullRedraw = false;
+            repaint();
+        }
+
+        /** Draws the columns ending before endBlock, the same block for all channels */
+        void drawColumns (const int x, const int numNew, const juce::int64 endBlock, const int numChannels)
+        {
+            juce::Graphics g (image);
+            g.setColour (backgroundColour);
+            g.fillRect (x, 0, numNew, image.getHeight());
+
+            const auto rowHeight = float (image.getHeight()) / float (std::max (1, numChannels));
+            const auto scale     = rowHeight * 0.35f;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                const auto centre = rowHeight * (float (channel) + 0.5f);
+                g.setColour (centreLineColour);
+                g.drawHorizontalLine (int (centre), float (x), float (x + numNew));
+
+                outline.getChannelColumnsEndingAt (columns, channel, numNew, numNew * blocksPerPixel, endBlock);
+                for (int i = 0; i < columns.size(); ++i)
+                {
+                    const auto low  = columns.minValues [size_t (i)];
+                    const auto high = columns.maxValues [size_t (i)];
+                    g.setColour (high >= 1.0f || low <= -1.0f ? clipColour : waveformColour);
+                    g.fillRect (float (x + i), centre - high * scale, 1.0f, std::max (1.0f, (high - low) * scale));
+
+                    const auto rms = columns.rmsValues [size_t (i)];
+                    if (rms > 0.0f)
+                    {
+                        g.setColour (rmsColour);
+                        g.fillRect (float (x + i), centre - rms * scale, 1.0f, 2.0f * rms * scale);
+                    }
+                }
+            }
+        }
+
+        void updateColours()
+        {
+            if (dynamic_cast<LevelMeter::LookAndFeelMethods*> (&getLookAndFeel()) != nullptr)
+                fallbackLookAndFeel.reset();
+            else if (fallbackLookAndFeel == nullptr)
+                fallbackLookAndFeel = std::make_unique<LevelMeterLookAndFeel>();
+
+            auto colour = [this] (const int colourId)
+            {
+                return fallbackLookAndFeel != nullptr ? fallbackLookAndFeel->findColour (colourId) : findColour (colourId);
+            };
+
+            backgroundColour = colour (LevelMeter::lmBackgroundColour);
+            waveformColour   = colour (LevelMeter::lmMeterGradientLowColour);
+            clipColour       = colour (LevelMeter::lmMeterGradientMaxColour);
+            rmsColour        = colour (LevelMeter::lmMeterGradientMidColour);
+            centreLineColour = colour (LevelMeter::lmMeterBackgroundColour);
+            needsFullRedraw  = true;
+        }
+
+        OutlineBuffer&               outline;
+        OutlineBuffer::Columns       columns;
+        MeterConsumers::Registration registration;
+
+        juce::Image                  image;
+        juce::int64                  lastNumColumns  = 0;
+        int                          lastNumChannels = 0;
+        juce::uint64                 lastClearCount  = 0;
+        int                          blocksPerPixel  = 1;
+        int                          refreshRate     = 30;
+        bool                         needsFullRedraw = true;
+
+        juce::Colour                 backgroundColour;
+        juce::Colour                 waveformColour;
+        juce::Colour                 clipColour;
+        juce::Colour                 rmsColour;
+        juce::Colour                 centreLineColour;
+
+        std::unique_ptr<LevelMeterLookAndFeel> fallbackLookAndFeel;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OutlineComponent)
+    };
+    /*@}*/
+}
@@ -0,0 +1,439 @@
+/*
+ ==============================================================================
+ Copyright (c) 2017 - 2020 Foleys Finest Audio Ltd. - Daniel Walz
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+ 1. Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+ 3. Neither the name of the copyright holder nor the names of its contributors
+    may be used to endorse or promote products derived from this software without
+    specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+ ==============================================================================
+
+    OutlineHistory.h
+    Author:  Daniel Walz
+
+ ==============================================================================
+*/
+
+#pragma once
+
+namespace foleys
+{
+
+/** @addtogroup ff_meters */
+/*@{*/
+
+/**
+ \class OutlineHistory
+
+ A long min/max history in a memory mapped file, e.g. a 12 hour overview of a live recording.
+ Set it to an OutlineBuffer with OutlineBuffer::setHistory. The OutlineBuffer keeps the
+ recent blocks in RAM and copies them on a background thread to the file, the audio thread
+ never touches the file.
+
+ Each block takes 4 bytes: min and max are quantised to 16 bit with 12 dB headroom, which is
+ more than enough for drawing. Like the OutlineBuffer the file keeps a pyramid, so any range
+ can be read in a few reads per level. Each level of each channel is one sequential region,
+ the blocks are appended in time order, which keeps the page cache happy. When the capacity
+ is reached, the oldest blocks are overwritten.
+
+ The same file format is used for the peak files of whole audio files, see OutlinePeakFile.
+ */
+class OutlineHistory
+{
+public:
+    OutlineHistory() = default;
+
+    ~OutlineHistory()
+    {
+        close();
+    }
+
+    /**
+     Creates the file and maps it into memory. An existing file is replaced.
+     @param fileToUse the file, it should be on a local disk
+     @param numChannels the number of channels to store
+     @param numBlocks the capacity per channel, e.g. `12 * 3600 * sampleRate / samplesPerBlock`
+     @param pyramidFactor the decimation from one level to the next
+     @returns false, if the file couldn't be created or mapped
+     */
+    bool open (const juce::File& fileToUse, const int numChannels, const juce::int64 numBlocks, const int pyramidFactor = 8)
+    {
+        close();
+
+        channels = std::max (0, numChannels);
+        factor   = std::max (2, pyramidFactor);
+        capacity = std::max (juce::int64 (1), numBlocks);
+
+        const auto fileSize = createLevels();
+
+        fileToUse.deleteFile();
+        {
+            juce::FileOutputStream stream (fileToUse);
+            if (! stream.openedOk() || ! stream.setPosition (fileSize) || stream.truncate().failed())
+                return false;
+        }
+
+        auto mapped = std::make_unique<juce::MemoryMappedFile> (fileToUse, juce::MemoryMappedFile::readWrite);
+        if (mapped->getData() == nullptr || juce::int64 (mapped->getSize()) < fileSize)
+            return false;
+
+        map      = std::move (mapped);
+        file     = fileToUse;
+        writable = true;
+
+        auto* header = static_cast<char*> (map->getData());
+        std::memcpy (header, magic, 4);
+        writeHeaderValue (header + 4,  juce::int64 (version));
+        writeHeaderValue (header + 12, juce::int64 (channels));
+        writeHeaderValue (header + 20, juce::int64 (factor));
+        writeHeaderValue (header + 28, capacity);
+
+        pendingMin.assign (levels.size() * size_t (channels), 0.0f);
+        pendingMax.assign (levels.size() * size_t (channels), 0.0f);
+        return true;
+    }
+
+    /**
+     Maps an existing file read only, e.g. a peak file written by OutlinePeakFile. Nothing is
+     read, until a range is asked for, then the operating system pages in only what is needed.
+     @returns false, if the file is missing, of another version or truncated
+     */
+    bool openExisting (const juce::File& fileToUse)
+    {
+        close();
+
+        auto mapped = std::make_unique<juce::MemoryMappedFile> (fileToUse, juce::MemoryMappedFile::readOnly);
+        if (mapped->getData() == nullptr || juce::int64 (mapped->getSize()) < headerSize)
+            return false;
+
+        const auto* header = static_cast<const char*> (mapped->getData());
+        if (std::memcmp (header, magic, 4) != 0 || readHeaderValue (header + 4) != version)
+            return false;
+
+        const auto numChannels   = readHeaderValue (header + 12);
+        const auto pyramidFactor = readHeaderValue (header + 20);
+        const auto numBlocks     = readHeaderValue (header + 28);
+        if (numChannels < 0 || numChannels > 1024 || pyramidFactor < 2 || pyramidFactor > 1024 || numBlocks < 1)
+            return false;
+
+        channels = int (numChannels);
+        factor   = int (pyramidFactor);
+        capacity = numBlocks;
+
+        if (juce::int64 (mapped->getSize()) < createLevels())
+        {
+            levels.clear();
+            channels = 0;
+            return false;
+        }
+
+        map      = std::move (mapped);
+        file     = fileToUse;
+        writable = false;
+        return true;
+    }
+
+    /** Unmaps the file. The file stays on disk */
+    void close()
+    {
+        map.reset();
+        levels.clear();
+        channels = 0;
+        writable = false;
+    }
+
+    bool isOpen() const
+    {
+        return map != nullptr;
+    }
+
+    juce::File getFile() const
+    {
+        return file;
+    }
+
+    int getNumChannels() const
+    {
+        return channels;
+    }
+
+    /** The number of blocks stored per channel, before the oldest are overwritten */
+    juce::int64 getCapacity() const
+    {
+        return capacity;
+    }
+
+    /**
+     Stores, what the blocks were made from, so a cache can tell, if it is still up to date.
+     @param samplesPerBlock the number of samples of each block
+     @param sourceLength the length of the source in samples
+     @param sourceTime the time the source was modified, in milliseconds since 1970
+     */
+    void setSourceInfo (const int samplesPerBlock, const juce::int64 sourceLength, const juce::int64 sourceTime)
+    {
+        if (! writable)
+            return;
+
+        auto* header = static_cast<char*> (map->getData());
+        writeHeaderValue (header + 36, juce::int64 (samplesPerBlock));
+        writeHeaderValue (header + 44, sourceLength);
+        writeHeaderValue (header + 52, sourceTime);
+    }
+
+    int getSamplesPerBlock() const           { return int (readHeaderValue (36)); }
+    juce::int64 getSourceLength() const      { return readHeaderValue (44); }
+    juce::int64 getSourceTime() const        { return readHeaderValue (52); }
+
+    /** The number of blocks appended to the channel since open */
+    juce::int64 getNumBlocks (const int channel) const
+    {
+        if (! juce::isPositiveAndBelow (channel, channels))
+            return 0;
+
+        return getCount (channel).load (std::memory_order_acquire);
+    }
+
+    /**
+     Appends a block to the channel. Only one thread may append, the OutlineBuffer does that
+     from its background thread.
+     */
+    void append (const int channel, const float minValue, const float maxValue)
+    {
+        if (! writable || ! juce::isPositiveAndBelow (channel, channels))
+            return;
+
+        auto&      count = getCount (channel);
+        const auto index = count.load (std::memory_order_relaxed);
+        for (size_t k = 0; k < levels.size(); ++k)
+        {
+            const auto& level    = levels [k];
+            const auto  position = index % level.blocksPerEntry;
+            auto&       low      = pendingMin [k * size_t (channels) + size_t (channel)];
+            auto&       high     = pendingMax [k * size_t (channels) + size_t (channel)];
+            low  = position == 0 ? minValue : std::min (low,  minValue);
+            high = position == 0 ? maxValue : std::max (high, maxValue);
+
+            if (position == level.blocksPerEntry - 1)
+                getEntries (k, channel) [(index / level.blocksPerEntry) % level.numEntries].store (encode (low, high), std::memory_order_relaxed);
+        }
+
+        count.store (index + 1, std::memory_order_release);
+    }
+
+    /**
+     Writes one block of the lowest level directly, e.g. when several threads build a peak file
+     from different parts of the source. The blocks must fit into the capacity. Call buildPyramid,
+     when all blocks of the channel are written, only then they can be read.
+     */
+    void setBlock (const int channel, const juce::int64 index, const float minValue, const float maxValue)
+    {
+        if (! writable || ! juce::isPositiveAndBelow (channel, channels) || ! juce::isPositiveAndBelow (index, capacity))
+            return;
+
+        getEntries (0, channel) [index].store (encode (minValue, maxValue), std::memory_order_relaxed);
+    }
+
+    /**
+     Fills the levels above the lowest from the blocks written with setBlock, and publishes the
+     numBlocks blocks of the channel. The quantised values are merged as they are, so this adds
+     no rounding.
+     */
+    void buildPyramid (const int channel, const juce::int64 numBlocks)
+    {
+        if (! writable || ! juce::isPositiveAndBelow (channel, channels))
+            return;
+
+        const auto count = juce::jlimit (juce::int64 (0), capacity, numBlocks);
+        for (size_t k = 1; k < levels.size(); ++k)
+        {
+            const auto* below    = getEntries (k - 1, channel);
+            auto*       entries  = getEntries (k, channel);
+            const auto  numBelow = (count + levels [k - 1].blocksPerEntry - 1) / levels [k - 1].blocksPerEntry;
+
+            for (juce::int64 i = 0; i * factor < numBelow; ++i)
+            {
+                auto merged = below [i * factor].load (std::memory_order_relaxed);
+                for (juce::int64 j = i * factor + 1; j < std::min (numBelow, (i + 1) * factor); ++j)
+                    merged = merge (merged, below [j].load (std::memory_order_relaxed));
+
+                entries [i].store (merged, std::memory_order_relaxed);
+            }
+        }
+
+        getCount (channel).store (count, std::memory_order_release);
+    }
+
+    /**
+     Returns min and max of the blocks from first to end of a channel, counted since open. Blocks,
+     that were not written yet or already overwritten, read as silence. This can be called from
+     any thread, but it may need to read from disk.
+     */
+    juce::Range<float> getRange (const int channel, juce::int64 first, const juce::int64 end) const
+    {
+        if (! juce::isPositiveAndBelow (channel, channels) || first >= end)
+            return {};
+
+        const auto written = getCount (channel).load (std::memory_order_acquire);
+        const auto oldest  = std::max (juce::int64 (0), written - capacity);
+        const auto last    = std::min (end, written);
+
+        float minValue = 0.0f;
+        float maxValue = 0.0f;
+        bool  empty    = true;
+        if (first < oldest || last < end)
+        {
+            empty = false;
+            first = std::max (first, oldest);
+        }
+
+        while (first < last)
+        {
+            size_t k = 0;
+            while (k + 1 < levels.size())
+            {
+                const auto& next = levels [k + 1];
+                const auto  span = next.blocksPerEntry;
+                if (first % span != 0 || first + span > last || first / span < written / span - next.numEntries)
+                    break;
+
+                ++k;
+            }
+
+            const auto& level = levels [k];
+            const auto  range = decode (getEntries (k, channel) [(first / level.blocksPerEntry) % level.numEntries].load (std::memory_order_relaxed));
+            minValue = empty ? range.getStart() : std::min (minValue, range.getStart());
+            maxValue = empty ? range.getEnd()   : std::max (maxValue, range.getEnd());
+            empty    = false;
+            first   += level.blocksPerEntry;
+        }
+
+        return { minValue, maxValue };
+    }
+
+private:
+    struct Level
+    {
+        juce::int64 blocksPerEntry = 1;
+        juce::int64 numEntries     = 0;
+        juce::int64 offset         = 0;   /**< The first byte of the level in the file */
+        juce::int64 channelStride  = 0;   /**< The bytes from one channel to the next */
+    };
+
+    static_assert (sizeof (std::atomic<juce::uint32>) == sizeof (juce::uint32) && sizeof (std::atomic<juce::int64>) == sizeof (juce::int64),
+                   "The entries are accessed in place in the mapped file");
+
+    std::atomic<juce::uint32>* getEntries (const size_t level, const int channel) const
+    {
+        auto* data = static_cast<char*> (map->getData()) + levels [level].offset + levels [level].channelStride * channel;
+        return reinterpret_cast<std::atomic<juce::uint32>*> (data);
+    }
+
+    std::atomic<juce::int64>& getCount (const int channel) const
+    {
+        auto* data = static_cast<char*> (map->getData()) + headerSize;
+        return reinterpret_cast<std::atomic<juce::int64>*> (data) [channel];
+    }
+
+    /** The min is rounded down and the max up, so the outline never gets smaller */
+    static juce::uint32 encode (const float minValue, const float maxValue)
+    {
+        const auto low  = juce::jlimit (-32768, 32767, int (std::floor (minValue * scale)));
+        const auto high = juce::jlimit (-32768, 32767, int (std::ceil  (maxValue * scale)));
+        return juce::uint32 (juce::uint16 (low)) | (juce::uint32 (juce::uint16 (high)) << 16);
+    }
+
+    static juce::Range<float> decode (const juce::uint32 entry)
+    {
+        return { float (juce::int16 (entry & 0xffff)) / scale, float (juce::int16 (entry >> 16)) / scale };
+    }
+
+    static juce::uint32 merge (const juce::uint32 a, const juce::uint32 b)
+    {
+        const auto low  = std::min (juce::int16 (a & 0xffff), juce::int16 (b & 0xffff));
+        const auto high = std::max (juce::int16 (a >> 16),    juce::int16 (b >> 16));
+        return juce::uint32 (juce::uint16 (low)) | (juce::uint32 (juce::uint16 (high)) << 16);
+    }
+
+    /** Lays out the levels for channels, factor and capacity, and returns the size of the file */
+    juce::int64 createLevels()
+    {
+        levels.clear();
+        auto offset = roundUpToPage (headerSize + juce::int64 (sizeof (juce::int64)) * channels);
+        for (juce::int64 blocksPerEntry = 1; levels.empty() || blocksPerEntry < capacity; blocksPerEntry *= factor)
+        {
+            Level level;
+            level.blocksPerEntry = blocksPerEntry;
+            level.numEntries     = levels.empty() ? capacity : (capacity + blocksPerEntry - 1) / blocksPerEntry + 1;
+            level.offset         = offset;
+            level.channelStride  = roundUpToPage (level.numEntries * juce::int64 (sizeof (juce::uint32)));
+            offset += level.channelStride * channels;
+            levels.push_back (level);
+        }
+
+        return offset;
+    }
+
+    static void writeHeaderValue (char* destination, const juce::int64 value)
+    {
+        std::memcpy (destination, &value, sizeof (value));
+    }
+
+    static juce::int64 readHeaderValue (const char* source)
+    {
+        juce::int64 value = 0;
+        std::memcpy (&value, source, sizeof (value));
+        return value;
+    }
+
+    juce::int64 readHeaderValue (const int position) const
+    {
+        return map != nullptr ? readHeaderValue (static_cast<const char*> (map->getData()) + position) : 0;
+    }
+
+    static juce::int64 roundUpToPage (const juce::int64 numBytes)
+    {
+        return (numBytes + pageSize - 1) / pageSize * pageSize;
+    }
+
+    static constexpr juce::int64 pageSize   = 4096;
+    static constexpr juce::int64 headerSize = 64;
+    static constexpr int         version    = 1;
+    static constexpr const char* magic      = "FFOH";
+    static constexpr float       scale      = 32767.0f / 4.0f;   // +12 dB headroom
+
+    juce::File                              file;
+    std::unique_ptr<juce::MemoryMappedFile> map;
+    std::vector<Level>                      levels;
+    std::vector<float>                      pendingMin;
+    std::vector<float>                      pendingMax;
+    int                                     channels = 0;
+    int                                     factor   = 8;
+    juce::int64                             capacity = 1;
+    bool                                    writable = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OutlineHistory)
+};
+
+/*@}*/
+
+} // end namespace foleys
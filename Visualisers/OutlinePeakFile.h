@@ -0,0 +1,267 @@
+/*
+ ==============================================================================
+ Copyright (c) 2017 - 2020 Foleys Finest Audio Ltd. - Daniel Walz
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+ 1. Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+ 3. Neither the name of the copyright holder nor the names of its contributors
+    may be used to endorse or promote products derived from this software without
+    specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ==============================================================================
+
+    OutlinePeakFile.h
+    Author:  Daniel Walz
+
+ ==============================================================================
+*/
+
+#pragma once
+
+#if JUCE_MODULE_AVAILABLE_juce_audio_formats
+
+namespace foleys
+{
+
+/** @addtogroup ff_meters */
+/*@{*/
+
+/**
+ \class OutlinePeakFile
+ \brief Builds and caches the overview of a whole audio file
+
+ The min and max of each block of the audio file are written to a peak file next to it, in the
+ format of the OutlineHistory. Several threads read different parts of the audio file at the
+ same time. When the session is opened again, the peak file is only memory mapped, so the
+ overview shows up instantly, and only the pages, that are drawn, are read from disk.
+
+ The peak file remembers the length and the modification time of the audio file and the block
+ size. If any of them changed, it is built again.
+
+ \code{.cpp}
+     juce::AudioFormatManager formats;
+     formats.registerBasicFormats();
+
+     // on a background thread, building a multi-GB file takes a while
+     overview = foleys::OutlinePeakFile::openOrBuild (formats, audioFile);
+
+     // in paint
+     auto range = overview->getRange (channel, firstBlock, firstBlock + blocksPerPixel);
+ \endcode
+
+ This class is only available, if the juce_audio_formats module is part of your project.
+ */
+class OutlinePeakFile
+{
+public:
+    /** Returns the peak file for an audio file, e.g. "take1.wav.ffpeak" */
+    static juce::File getPeakFileFor (const juce::File& audioFile)
+    {
+        return audioFile.getSiblingFile (audioFile.getFileName() + ".ffpeak");
+    }
+
+    /**
+     Maps the peak file of the audio file, if it is up to date, otherwise builds it.
+     @returns the overview, or nullptr, if the audio file can't be read
+     */
+    static std::unique_ptr<OutlineHistory> openOrBuild (juce::AudioFormatManager& formats, const juce::File& audioFile,
+                                                        int samplesPerBlock = 256, int numThreads = juce::SystemStats::getNumCpus())
+    {
+        if (auto overview = open (audioFile, samplesPerBlock))
+            return overview;
+
+        return build (formats, audioFile, samplesPerBlock, numThreads);
+    }
+
+    /**
+     Maps the peak file of the audio file read only, if it exists and matches the audio file.
+     @returns the overview, or nullptr, if there is no up to date peak file
+     */
+    static std::unique_ptr<OutlineHistory> open (const juce::File& audioFile, int samplesPerBlock = 256)
+    {
+        const auto peakFile = getPeakFileFor (audioFile);
+        if (! peakFile.existsAsFile())
+            return {};
+
+        auto overview = std::make_unique<OutlineHistory>();
+        if (! overview->openExisting (peakFile)
+            || overview->getSamplesPerBlock() != samplesPerBlock
+            || overview->getSourceTime() != audioFile.getLastModificationTime().toMilliseconds())
+            return {};
+
+        const auto numBlocks = (overview->getSourceLength() + samplesPerBlock - 1) / samplesPerBlock;
+        for (int channel = 0; channel < overview->getNumChannels(); ++channel)
+            if (overview->getNumBlocks (channel) != numBlocks)
+                return {};
+
+        return overview;
+    }
+
+    /**
+     Reads the whole audio file and writes its peak file. The file is split into chunks, and
+     numThreads threads, including the calling one, read them with their own reader. The peak
+     file is written under a temporary name and renamed, when it is complete, so a cancelled
+     build never leaves a broken cache behind.
+     @returns the overview mapped read only, or nullptr, if the audio file can't be read or the
+     peak file can't be written
+     */
+    static std::unique_ptr<OutlineHistory> build (juce::AudioFormatManager& formats, const juce::File& audioFile,
+                                                  int samplesPerBlock = 256, int numThreads = juce::SystemStats::getNumCpus())
+    {
+        samplesPerBlock = std::max (1, samplesPerBlock);
+
+        // each thread needs its own reader, they are all created here
+        std::vector<std::unique_ptr<juce::AudioFormatReader>> readers;
+        for (int i = 0; i < std::max (1, numThreads); ++i)
+        {
+            std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (audioFile));
+            if (reader == nullptr)
+                break;
+
+            readers.push_back (std::move (reader));
+        }
+
+        if (readers.empty())
+            return {};
+
+        const auto  numChannels = int (readers.front()->numChannels);
+        const auto  length      = readers.front()->lengthInSamples;
+        const auto  numBlocks   = std::max (juce::int64 (1), (length + samplesPerBlock - 1) / samplesPerBlock);
+        const auto  peakFile    = getPeakFileFor (audioFile);
+        const auto  tempFile    = peakFile.getSiblingFile (peakFile.getFileName() + ".part");
+
+        {
+            OutlineHistory overview;
+            if (! overview.open (tempFile, numChannels, numBlocks))
+                return {};
+
+            Job job (overview, samplesPerBlock, length, numBlocks);
+
+            std::vector<std::unique_ptr<Worker>> workers;
+            for (size_t i = 1; i < readers.size(); ++i)
+            {
+                workers.push_back (std::make_unique<Worker> (job, *readers [i]));
+                workers.back()->startThread();
+            }
+
+            job.readChunks (*readers.front());
+
+            for (auto& worker : workers)
+                worker->waitForThreadToExit (-1);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                overview.buildPyramid (channel, numBlocks);
+
+            overview.setSourceInfo (samplesPerBlock, length, audioFile.getLastModificationTime().toMilliseconds());
+        }
+
+        peakFile.deleteFile();
+        if (! tempFile.moveFileTo (peakFile))
+            return {};
+
+        auto overview = std::make_unique<OutlineHistory>();
+        if (! overview->openExisting (peakFile))
+            return {};
+
+        return overview;
+    }
+
+private:
+    /** The chunks of the audio file, claimed one after the other by all threads */
+    class Job
+    {
+    public:
+        Job (OutlineHistory& overviewToUse, int samplesPerBlockToUse, juce::int64 lengthToUse, juce::int64 numBlocksToUse)
+          : overview (overviewToUse),
+            samplesPerBlock (samplesPerBlockToUse),
+            length (lengthToUse),
+            numBlocks (numBlocksToUse),
+            blocksPerChunk (std::max (1, samplesPerChunk / samplesPerBlockToUse))
+        {
+        }
+
+        void readChunks (juce::AudioFormatReader& reader)
+        {
+            juce::AudioBuffer<float> buffer (int (reader.numChannels), blocksPerChunk * samplesPerBlock);
+
+            for (;;)
+            {
+                const auto firstBlock = nextBlock.fetch_add (blocksPerChunk);
+                if (firstBlock >= numBlocks)
+                    return;
+
+                const auto start      = firstBlock * samplesPerBlock;
+                const auto numSamples = int (std::min (juce::int64 (buffer.getNumSamples()), length - start));
+                if (numSamples > 0 && ! reader.read (&buffer, 0, numSamples, start, true, true))
+                    buffer.clear();
+
+                for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                {
+                    const auto* data = buffer.getReadPointer (channel);
+                    for (int offset = 0; offset < numSamples; offset += samplesPerBlock)
+                    {
+                        const auto range = juce::FloatVectorOperations::findMinAndMax (data + offset, std::min (samplesPerBlock, numSamples - offset));
+                        overview.setBlock (channel, firstBlock + offset / samplesPerBlock, range.getStart(), range.getEnd());
+                    }
+                }
+            }
+        }
+
+    private:
+        static constexpr int samplesPerChunk = 65536;
+
+        OutlineHistory&          overview;
+        const int                samplesPerBlock;
+        const juce::int64        length;
+        const juce::int64        numBlocks;
+        const int                blocksPerChunk;
+        std::atomic<juce::int64> nextBlock { 0 };
+
+        JUCE_DECLARE_NON_COPYABLE (Job)
+    };
+
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker (Job& jobToUse, juce::AudioFormatReader& readerToUse)
+          : juce::Thread ("Peak file"),
+            job (jobToUse),
+            reader (readerToUse)
+        {
+        }
+
+        void run() override
+        {
+            job.readChunks (reader);
+        }
+
+    private:
+        Job&                     job;
+        juce::AudioFormatReader& reader;
+
+        JUCE_DECLARE_NON_COPYABLE (Worker)
+    };
+};
+
+/*@}*/
+
+} // end namespace foleys
+
+#endif // JUCE_MODULE_AVAILABLE_juce_audio_formats
@@ -55,6 +55,7 @@ namespace foleys
         juce::AudioBuffer<FloatType> sampleBuffer;
         std::atomic<int>             writePosition = { 0 };
         std::vector<FloatType>       maxValues     = { 180, 0.0 };
+        MeterConsumers               consumers;
 
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StereoFieldBuffer)
 
@@ -93,6 +94,16 @@ namespace foleys
         {
             jassert (buffer.getNumChannels() == sampleBuffer.getNumChannels());
 
+            if (! consumers.shouldProcess (numSamples))
+                return;
+
+            if (consumers.checkResumed())
+            {
+                sampleBuffer.clear();
+                writePosition = 0;
+                resetMaxValues();
+            }
+
             auto pos   = writePosition.load();
             auto space = sampleBuffer.getNumSamples() - pos;
             if (space >= numSamples) {
@@ -115,6 +126,15 @@ namespace foleys
             std::fill (maxValues.begin(), maxValues.end(), 0.0);
         }
 
+        /**
+         The StereoFieldComponent registers here while it is showing. While nobody is
+         interested, the pushed blocks are skipped.
+         */
+        MeterConsumers& getConsumers ()
+        {
+            return consumers;
+        }
+
         //  ==============================================================================
 
         juce::Path getOscilloscope (const int numSamples, const juce::Rectangle<FloatType> bounds, int leftIdx, int rightIdx) const
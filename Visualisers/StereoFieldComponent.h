@@ -50,7 +50,8 @@ namespace foleys
      At any time the GUI can ask for a stereo field visualisation of
      two neightbouring channels.
      */
-    class StereoFieldComponent : public juce::Component
+    class StereoFieldComponent : public juce::Component,
+                                 private juce::Timer
     {
     public:
         enum
@@ -94,6 +95,23 @@ namespace foleys
         StereoFieldComponent (StereoFieldBuffer<float>& stereo)
         : stereoBuffer (stereo)
         {
+            registration.setConsumers (&stereoBuffer.getConsumers());
+            startTimerHz (visibilityCheckRate);
+        }
+
+        ~StereoFieldComponent() override
+        {
+            stopTimer();
+        }
+
+        void visibilityChanged () override
+        {
+            registration.setInterested (isShowing());
+        }
+
+        void parentHierarchyChanged () override
+        {
+            registration.setInterested (isShowing());
         }
 
         void paint (juce::Graphics& g) override
@@ -129,8 +147,17 @@ namespace foleys
         }
 
     private:
-        StereoFieldBuffer<float>& stereoBuffer;
-        int                       type = GonioMeter;
+        void timerCallback() override
+        {
+            // a parent being shown or hidden doesn't call visibilityChanged, so this is checked here as well
+            registration.setInterested (isShowing());
+        }
+
+        static constexpr int visibilityCheckRate = 10;
+
+        StereoFieldBuffer<float>&    stereoBuffer;
+        MeterConsumers::Registration registration;
+        int                          type = GonioMeter;
 
         float margin = 5.0f;
         float border = 2.0f;
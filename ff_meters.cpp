@@ -30,3 +30,4 @@
 #include "ff_meters.h"
 
 #include "LevelMeter/LevelMeter.cpp"
+#include "LevelMeter/LevelMeterBridge.cpp"
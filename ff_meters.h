@@ -61,16 +61,37 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_events/juce_events.h>
 
+#if JUCE_MODULE_AVAILABLE_juce_audio_formats
+#include <juce_audio_formats/juce_audio_formats.h>
+#endif
+
 #include <atomic>
 #include <vector>
 #include <numeric>
+#include <map>
+#include <mutex>
+#include <array>
+#include <cstdint>
 
+#include "Utilities/LockFreeFifo.h"
+#include "Utilities/MeterConsumers.h"
+#include "Utilities/MeterWorkerPool.h"
+#include "LevelMeter/LevelMeterMetrics.h"
 #include "LevelMeter/LevelMeterSource.h"
+#include "LevelMeter/LevelEventDetector.h"
+#include "LevelMeter/MeterScale.h"
 #include "LevelMeter/LevelMeter.h"
+#include "LevelMeter/LevelMeterBridge.h"
+#include "Visualisers/OutlineHistory.h"
 #include "Visualisers/OutlineBuffer.h"
+#include "Visualisers/OutlinePeakFile.h"
 #include "Visualisers/StereoFieldBuffer.h"
 #include "Visualisers/StereoFieldComponent.h"
 #include "LookAndFeel/LevelMeterLookAndFeel.h"
+#include "Visualisers/OutlineComponent.h"
+#include "LevelMeter/MeterRenderHarness.h"
+#include "Utilities/MeterWorkerBenchmark.h"
+#include "Utilities/OutlineFormatBenchmark.h"
 
 // stay backwards compatible
 namespace FFAU=foleys;